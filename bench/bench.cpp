@@ -0,0 +1,89 @@
+#include <iostream>
+#include <iomanip>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "bench.hpp"
+#include "common/alloc_probe.hpp"
+
+static std::string filter;
+
+// library counts allocations itself when built with probes
+#ifndef COMMON_ALLOC_PROBES
+static std::atomic<uint64_t> alloc_count{0};
+static std::atomic<uint64_t> alloc_bytes{0};
+
+void* operator new(std::size_t size) {
+
+	alloc_count.fetch_add(1, std::memory_order_relaxed);
+	alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+
+	if ( void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+
+	alloc_count.fetch_add(1, std::memory_order_relaxed);
+	alloc_bytes.fetch_add(size, std::memory_order_relaxed);
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+	return ::operator new(size, tag);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+
+bench::counters bench::allocations() {
+
+	return { alloc_count.load(std::memory_order_relaxed), alloc_bytes.load(std::memory_order_relaxed) };
+}
+#else
+bench::counters bench::allocations() {
+
+	common::alloc::counters c = common::alloc::thread_counters();
+	return { c.allocs, c.bytes };
+}
+#endif
+
+void bench::init(int argc, char **argv) {
+
+	if ( argc > 1 )
+		filter = argv[1];
+
+	std::cout << std::left << std::setw(44) << "benchmark" << std::right <<
+		std::setw(12) << "iterations" << std::setw(14) << "ns/op" <<
+		std::setw(12) << "bytes/op" << std::setw(11) << "allocs/op" << std::endl;
+}
+
+bool bench::selected(const std::string& name) {
+
+	return filter.empty() || name.find(filter) != std::string::npos;
+}
+
+void bench::report(const std::string& name, uint64_t iterations, uint64_t ns, const bench::counters& allocs, size_t input_bytes) {
+
+	double per_op = (double)ns / iterations;
+
+	std::cout << std::left << std::setw(44) << name << std::right <<
+		std::setw(12) << iterations <<
+		std::setw(14) << std::fixed << std::setprecision(1) << per_op <<
+		std::setw(12) << std::setprecision(0) << (double)allocs.bytes / iterations <<
+		std::setw(11) << std::setprecision(2) << (double)allocs.allocs / iterations;
+
+	if ( input_bytes != 0 )
+		std::cout << std::setw(10) << std::setprecision(1) << ( input_bytes / per_op * 1e9 / ( 1024 * 1024 )) << " MiB/s";
+
+	std::cout << std::endl;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+#include <cstddef>
+#include <algorithm>
+
+// microbenchmark harness shared by bench programs. Every operation is run
+// in batches until at least min_time has passed, allocations are counted
+// by replacement operators new and delete in bench.cpp.
+//
+// Output is one line per benchmark:
+// name  iterations  ns/op  bytes/op  allocs/op  [MiB/s]
+// where bytes/op and allocs/op are heap bytes and allocations per operation.
+
+namespace bench {
+
+	struct counters {
+		uint64_t allocs;
+		uint64_t bytes;
+	};
+
+	counters allocations();
+
+	// benchmark name filter from command line, empty runs everything
+	void init(int argc, char **argv);
+	bool selected(const std::string& name);
+	void report(const std::string& name, uint64_t iterations, uint64_t ns, const counters& allocs, size_t input_bytes);
+
+	// prevents compiler from optimizing away result
+	template<typename T>
+	inline void keep(T&& value) {
+		asm volatile("" : : "g"(&value) : "memory");
+	}
+
+	// input_bytes is size of input processed per operation, when not 0,
+	// throughput is reported too
+	template<typename F>
+	void run(const std::string& name, F&& f, size_t input_bytes = 0) {
+
+		if ( !bench::selected(name))
+			return;
+
+		const uint64_t min_time = 200000000; // 200ms
+		uint64_t batch = 1;
+
+		f(); // warm up
+
+		while ( true ) {
+
+			counters before = bench::allocations();
+			auto start = std::chrono::steady_clock::now();
+
+			for ( uint64_t i = 0; i < batch; i++ )
+				f();
+
+			uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+			counters after = bench::allocations();
+
+			if ( ns >= min_time || batch >= ( 1ULL << 32 )) {
+				bench::report(name, batch, ns, { after.allocs - before.allocs, after.bytes - before.bytes }, input_bytes);
+				return;
+			}
+
+			// aim past min_time with next batch
+			batch = ns < 1000 ? batch * 100 : std::max(batch * 2, (uint64_t)( batch * 1.2 * min_time / ns ));
+		}
+	}
+}
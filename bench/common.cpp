@@ -0,0 +1,227 @@
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <filesystem>
+#include <unistd.h>
+
+#include "common.hpp"
+#include "lowercase_map.hpp"
+#include "featureset.hpp"
+#include "common/scanner.hpp"
+#include "common/alloc_probe.hpp"
+#include "common/batch_read.hpp"
+#include "common/proctable.hpp"
+#include "common/meminfo.hpp"
+#include "common/thread_pool.hpp"
+#include "common/parallel_split.hpp"
+#include "bench.hpp"
+
+// microbenchmarks of common library functions over /proc like inputs,
+// run with a substring of benchmark names as argument to select a subset
+
+static std::string meminfo_text() {
+
+	static const char* keys[] = {
+		"MemTotal", "MemFree", "MemAvailable", "Buffers", "Cached", "SwapCached",
+		"Active", "Inactive", "Active(anon)", "Inactive(anon)", "Active(file)",
+		"Inactive(file)", "Unevictable", "Mlocked", "SwapTotal", "SwapFree",
+		"Dirty", "Writeback", "AnonPages", "Mapped", "Shmem", "KReclaimable",
+		"Slab", "SReclaimable", "SUnreclaim", "KernelStack", "PageTables",
+		"NFS_Unstable", "Bounce", "WritebackTmp", "CommitLimit", "Committed_AS",
+		"VmallocTotal", "VmallocUsed", "VmallocChunk", "Percpu", "HardwareCorrupted",
+		"AnonHugePages", "ShmemHugePages", "ShmemPmdMapped", "FileHugePages",
+		"FilePmdMapped", "HugePages_Total", "HugePages_Free", "HugePages_Rsvd",
+		"HugePages_Surp", "Hugepagesize", "Hugetlb", "DirectMap4k", "DirectMap2M",
+		"DirectMap1G"
+	};
+
+	std::string text;
+	unsigned long v = 16318472;
+
+	for ( const char* key : keys ) {
+		std::string value = std::to_string(v);
+		text += std::string(key) + ":" + std::string(16 - std::min<size_t>(15, std::string(key).size()), ' ') +
+			std::string(8 - std::min<size_t>(7, value.size()), ' ') + value + " kB\n";
+		v = v * 7 / 11 + 13;
+	}
+
+	return text;
+}
+
+enum class feature { ipv4, ipv6, bridge, vlan, wireless, tunnel, loopback, dhcp };
+
+int main(int argc, char **argv) {
+
+	bench::init(argc, argv);
+
+	const std::string meminfo = meminfo_text();
+	const std::string stat_line = "cpu  4705356 584 369923 23302731 2334 0 15671 0 0 0";
+	const std::string padded = "  \t  Committed_AS:    8814300 kB \r\n";
+	const std::string quoted = "   \"  /usr/lib/systemd/systemd --switched-root --system  \"  ";
+
+	std::filesystem::path path = std::filesystem::temp_directory_path() / ( "bench_common_" + std::to_string(getpid()));
+	std::ofstream(path) << meminfo;
+
+	// lines and split
+	bench::run("lines(meminfo)", [&]() { bench::keep(common::lines(meminfo)); }, meminfo.size());
+	bench::run("lines(meminfo, '\\n')", [&]() { bench::keep(common::lines(meminfo, '\n')); }, meminfo.size());
+	bench::run("split(stat_line, ' ')", [&]() { bench::keep(common::split(stat_line, ' ')); }, stat_line.size());
+	bench::run("split(meminfo, \"kB\\n\")", [&]() { bench::keep(common::split(meminfo, "kB\n")); }, meminfo.size());
+
+	// trimming
+	bench::run("trim_ws", [&]() { bench::keep(common::trim_ws(padded)); });
+	bench::run("ltrim_ws", [&]() { bench::keep(common::ltrim_ws(padded)); });
+	bench::run("rtrim_ws", [&]() { bench::keep(common::rtrim_ws(padded)); });
+	bench::run("trimmed", [&]() { bench::keep(common::trimmed(padded, common::whitespace)); });
+	bench::run("unquoted_and_trimmed", [&]() { bench::keep(common::unquoted_and_trimmed(quoted)); });
+
+	// scanner
+	bench::run("scan(stat_line, 4 fields)", [&]() {
+		unsigned long user, nice, system, idle;
+		common::scan(stat_line, {{ 1, &user }, { 2, &nice }, { 3, &system }, { 4, &idle }});
+		bench::keep(user + nice + system + idle);
+	}, stat_line.size());
+
+	// parseFile
+	bench::run("parseFile(meminfo)", [&]() { bench::keep(common::parseFile(path.string())); }, meminfo.size());
+
+	// fixed schema decoder
+	bench::run("meminfo::decode", [&]() {
+		common::meminfo m;
+		bench::keep(m.decode(meminfo));
+	}, meminfo.size());
+
+	// hash and fmt
+	bench::run("hash(\"MemAvailable\")", [&]() { bench::keep(common::hash("MemAvailable")); });
+	bench::run("hash(\"HugePages_Surp\")", [&]() { bench::keep(common::hash("HugePages_Surp")); });
+	bench::run("fmt(\"%s: %lu kB\")", [&]() { bench::keep(common::fmt("%s: %lu kB", "MemTotal", 16318472UL)); });
+	bench::run("fmt(\"%.2f%%\")", [&]() { bench::keep(common::fmt("%.2f%%", 43.219)); });
+
+	// lowercase_map lookups
+	common::lowercase_map<std::string> map = common::parseFile(path.string());
+	std::vector<std::string> hits = { "memtotal", "MemAvailable", "SWAPFREE", "hugepagesize", "DirectMap2M" };
+	std::vector<std::string> misses = { "memused", "SwapUsed", "NotThere", "x", "directmap8g" };
+
+	bench::run("lowercase_map::contains, 5 hits", [&]() {
+		size_t n = 0;
+		for ( const std::string& key : hits )
+			n += map.contains(key);
+		bench::keep(n);
+	});
+
+	bench::run("lowercase_map::contains, 5 misses", [&]() {
+		size_t n = 0;
+		for ( const std::string& key : misses )
+			n += map.contains(key);
+		bench::keep(n);
+	});
+
+	bench::run("lowercase_map::at, 5 hits", [&]() {
+		size_t n = 0;
+		for ( const std::string& key : hits )
+			n += map.at(key).size();
+		bench::keep(n);
+	});
+
+	// FeatureSet
+	FeatureSet<feature> features = { feature::ipv4, feature::bridge, feature::dhcp };
+
+	bench::run("FeatureSet::contains", [&]() {
+		bench::keep(features.contains(feature::dhcp) + features.contains(feature::wireless));
+	});
+
+	bench::run("FeatureSet set + unset", [&]() {
+		features.set(feature::vlan);
+		features.unset(feature::vlan);
+		bench::keep(features.size());
+	});
+
+	bench::run("FeatureSet construct", [&]() {
+		FeatureSet<feature> f = { feature::ipv4, feature::ipv6, feature::loopback };
+		bench::keep(f.size());
+	});
+
+	// reading stat of every process
+	common::proc_table procs;
+	std::vector<std::string> stat_files;
+
+	for ( pid_t pid : procs.sample().pid )
+		stat_files.push_back("/proc/" + std::to_string(pid) + "/stat");
+
+	bench::run("read /proc/*/stat, ifstream (" + std::to_string(stat_files.size()) + " files)", [&]() {
+		size_t n = 0;
+		for ( const std::string& f : stat_files ) {
+			std::ifstream fd(f);
+			std::string line;
+			std::getline(fd, line);
+			n += line.size();
+		}
+		bench::keep(n);
+	});
+
+	for ( bool uring : { true, false }) {
+
+		common::batch_reader reader(256, uring);
+
+		bench::run(std::string("read /proc/*/stat, batch_reader ") + ( reader.using_io_uring() ? "io_uring" : "pread" ), [&]() {
+			reader.clear();
+			for ( const std::string& f : stat_files )
+				reader.add(f, 512);
+			reader.submit();
+			bench::keep(reader.size());
+		});
+	}
+
+	// parsing status of every process, sequentially and on a pool
+	std::vector<std::string> status_files;
+
+	for ( pid_t pid : procs.sample().pid )
+		status_files.push_back("/proc/" + std::to_string(pid) + "/status");
+
+	bench::run("parseFile /proc/*/status, sequential", [&]() {
+		size_t n = 0;
+		for ( const std::string& f : status_files ) {
+			try { n += common::parseFile(f).size(); }
+			catch ( const std::runtime_error& ) {}
+		}
+		bench::keep(n);
+	});
+
+	common::thread_pool pool;
+
+	bench::run("parseFile /proc/*/status, " + std::to_string(pool.size() + 1) + " threads", [&]() {
+		std::vector<size_t> sizes = pool.parallel_transform(status_files, [](const std::string& f) -> size_t {
+			try { return common::parseFile(f).size(); }
+			catch ( const std::runtime_error& ) { return 0; }
+		});
+		bench::keep(sizes.size());
+	});
+
+	// tokenizing a log like buffer
+	std::string log;
+
+	while ( log.size() < 64 * 1024 )
+		log += "2024-01-01T00:00:00 host agent[" + std::to_string(log.size()) + "]: sample cycle done\r\n";
+
+	bench::run("lines, 64 KiB log", [&]() {
+		bench::keep(common::lines(log, '\n').size());
+	}, log.size());
+
+	bench::run("parallel_lines, 64 KiB log", [&]() {
+		bench::keep(common::parallel_lines(log, '\n', "\r", pool, 16 * 1024).size());
+	}, log.size());
+
+	bench::run("parallel_tokenize, 64 KiB log", [&]() {
+		bench::keep(common::parallel_tokenize(log, '\n', false, pool, 16 * 1024).size());
+	}, log.size());
+
+	std::filesystem::remove(path);
+
+#ifdef COMMON_ALLOC_PROBES
+	std::cout << std::endl;
+	common::alloc::dump(std::cout);
+#endif
+
+	return 0;
+}
@@ -0,0 +1,174 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <stdexcept>
+
+#include "common/json.hpp"
+#include "common/json_tape.hpp"
+#include "bench.hpp"
+
+// in-situ json::parse, also into an rva::arena, and json::lazy against a naive recursive descent
+// parser that copies every string and keeps objects in std::map.
+// Library objects follow CXXFLAGS, build with -O2 for comparable numbers:
+// make bench CXXFLAGS="--std=c++17 -Wall -fPIC -O2"
+
+static const size_t records = 40000;
+
+namespace naive {
+
+	struct node {
+		enum { null, boolean, number, string, array, object } kind = null;
+		bool b = false;
+		double d = 0;
+		std::string s;
+		std::vector<node> items;
+		std::map<std::string, node> members;
+	};
+
+	struct parser {
+
+		const std::string& src;
+		size_t pos = 0;
+
+		void ws() {
+			while ( pos < src.size() && std::isspace((unsigned char)src[pos]))
+				pos++;
+		}
+
+		std::string str() {
+			std::string s;
+			pos++;
+			while ( src.at(pos) != '"' ) {
+				if ( src[pos] == '\\' ) {
+					pos++;
+					switch ( src.at(pos)) {
+						case 'n': s += '\n'; break;
+						case 't': s += '\t'; break;
+						default: s += src[pos];
+					}
+				} else s += src[pos];
+				pos++;
+			}
+			pos++;
+			return s;
+		}
+
+		node value() {
+			node n;
+			ws();
+			char ch = src.at(pos);
+			if ( ch == '"' ) {
+				n.kind = node::string;
+				n.s = str();
+			} else if ( ch == '[' ) {
+				n.kind = node::array;
+				pos++; ws();
+				if ( src.at(pos) == ']' ) { pos++; return n; }
+				while ( true ) {
+					n.items.push_back(value());
+					ws();
+					if ( src.at(pos++) == ']' ) break;
+				}
+			} else if ( ch == '{' ) {
+				n.kind = node::object;
+				pos++; ws();
+				if ( src.at(pos) == '}' ) { pos++; return n; }
+				while ( true ) {
+					ws();
+					std::string key = str();
+					ws(); pos++;
+					n.members[key] = value();
+					ws();
+					if ( src.at(pos++) == '}' ) break;
+				}
+			} else if ( ch == 't' || ch == 'f' ) {
+				n.kind = node::boolean;
+				n.b = ch == 't';
+				pos += n.b ? 4 : 5;
+			} else if ( ch == 'n' ) {
+				pos += 4;
+			} else {
+				size_t e = src.find_first_of(",]} \n", pos);
+				std::stringstream ss(src.substr(pos, e - pos));
+				n.kind = node::number;
+				ss >> n.d;
+				pos = e;
+			}
+			return n;
+		}
+	};
+}
+
+int main(int argc, char **argv) {
+
+	bench::init(argc, argv);
+
+	std::string doc = "{\"host\":\"bench\",\"records\":[";
+
+	for ( size_t i = 0; i < records; i++ ) {
+		if ( i != 0 ) doc += ',';
+		doc += "{\"id\":" + std::to_string(i) +
+			",\"name\":\"process_" + std::to_string(i) + "\"" +
+			",\"cmdline\":\"/usr/bin/daemon --config /etc/daemon/" + std::to_string(i % 17) + ".conf\\t-v\"" +
+			",\"cpu\":" + std::to_string(( i % 1000 ) / 10.0) +
+			",\"running\":" + ( i % 3 == 0 ? "true" : "false" ) +
+			",\"parent\":null,\"threads\":[1,2,3,4]}";
+	}
+
+	doc += "]}";
+
+	bench::run("json naive recursive descent", [&doc]() {
+		naive::parser p{doc};
+		naive::node n = p.value();
+		bench::keep(n.members["records"].items.size());
+	}, doc.size());
+
+	bench::run("json::parse (in-situ)", [&doc]() {
+		std::string buf = doc;
+		common::json::value v = common::json::parse(buf);
+		auto& obj = std::get<common::json::object>(v);
+		bench::keep(std::get<common::json::array>(*common::json::find(obj, "records")).size());
+	}, doc.size());
+
+	rva::arena arena;
+
+	bench::run("json::parse (in-situ, rva::arena)", [&doc, &arena]() {
+		std::string buf = doc;
+		{
+			common::json::pmr::value v = common::json::parse(buf, arena);
+			auto& obj = std::get<common::json::pmr::object>(v);
+			bench::keep(std::get<common::json::pmr::array>(*common::json::find(obj, "records")).size());
+		}
+		arena.release();
+	}, doc.size());
+
+	bench::run("json::lazy, one field", [&doc]() {
+		common::json::lazy l(doc);
+		bench::keep(l["records"][records - 1]["id"].number());
+	}, doc.size());
+
+	std::string buf = doc;
+	common::json::value tree = common::json::parse(buf);
+	common::json::tape tape(tree);
+
+	bench::run("json tree lookups", [&tree]() {
+		auto& recs = std::get<common::json::array>(*common::json::find(std::get<common::json::object>(tree), "records"));
+		size_t n = 0;
+		for ( auto& r : recs )
+			n += (size_t)std::get<double>(*common::json::find(std::get<common::json::object>(r), "cpu"));
+		bench::keep(n);
+	}, doc.size());
+
+	bench::run("json tape lookups", [&tape]() {
+		auto recs = tape.root()["records"];
+		size_t n = 0;
+		for ( auto r : recs )
+			n += (size_t)r["cpu"].number();
+		bench::keep(n);
+	}, doc.size());
+
+	return 0;
+}
@@ -0,0 +1,52 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <utility>
+
+#include "common.hpp"
+#include "lowercase_map.hpp"
+#include "bench.hpp"
+
+// load time of a 50k entry lowercase_map, per-key insertion vs. bulk loading
+
+static const size_t entries = 50000;
+
+int main(int argc, char **argv) {
+
+	bench::init(argc, argv);
+
+	std::vector<std::pair<std::string, std::string>> src;
+	src.reserve(entries);
+
+	for ( size_t i = 0; i < entries; i++ )
+		src.emplace_back("config_key_" + std::to_string(i), "value " + std::to_string(i * 7));
+
+	bench::run("load, operator[]", [&src]() {
+		common::lowercase_map<std::string> m;
+		for ( auto& [key, value] : src )
+			m[key] = value;
+		bench::keep(m.size());
+	});
+
+	bench::run("load, insert(pair)", [&src]() {
+		common::lowercase_map<std::string> m;
+		for ( auto& p : src )
+			m.insert(p);
+		bench::keep(m.size());
+	});
+
+	bench::run("load, reserve + insert(first, last)", [&src]() {
+		common::lowercase_map<std::string> m;
+		m.reserve(src.size());
+		m.insert(src.begin(), src.end());
+		bench::keep(m.size());
+	});
+
+	bench::run("load, assign_unique(first, last)", [&src]() {
+		common::lowercase_map<std::string> m;
+		m.assign_unique(src.begin(), src.end());
+		bench::keep(m.size());
+	});
+
+	return 0;
+}
@@ -1,11 +1,14 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <sstream>
 #include <chrono>
 #include <ctime>
 #include <map>
+#include <deque>
+#include <utility>
 #include <filesystem>
 #include <algorithm>
 #include <unistd.h>
@@ -30,7 +33,7 @@ namespace common {
 
 	using char_type = std::string::value_type;
 
-	template <class T>
+	template <class T, class ValueTypeContainer = std::deque<std::pair<std::string, T>>>
 	class lowercase_map;
 
 	struct padding {
@@ -61,6 +64,11 @@ namespace common {
 
 		template<typename Rep, typename Period>
 		duration(const std::chrono::duration<Rep, Period> &d);
+
+		// time since start, measured with start's clock, for example
+		// common::clock::monotonic or common::clock::tsc
+		template<typename Clock>
+		static duration since(const std::chrono::time_point<Clock>& start);
 	};
 
 	static const std::string whitespace = " \t\n\r\f\v";
@@ -101,6 +109,11 @@ namespace common {
 	double to_MiB(unsigned long int bytes);
 	double to_GiB(unsigned long int bytes);
 
+	// batch versions, results are identical to converting values one by one
+	void to_KiB(const unsigned long int* bytes, double* out, size_t count);
+	void to_MiB(const unsigned long int* bytes, double* out, size_t count);
+	void to_GiB(const unsigned long int* bytes, double* out, size_t count);
+
 	// return file size / capacity in human readable format
 	std::string HumanReadable(const double &d);
 
@@ -163,6 +176,8 @@ namespace common {
 	inline bool vector_contains(const T& value, const std::vector<T>& values);
 
 	common::lowercase_map<std::string> parseFile(const std::string& filename, const common::char_type& delim = ':');
+	// same as parseFile, for contents already in memory
+	common::lowercase_map<std::string> parseBuffer(std::string_view data, const common::char_type& delim = ':');
 
 	long int timezone_diff(); // current timezone diff in seconds
 	std::chrono::system_clock::time_point mk_time_point(double d);
@@ -223,6 +238,11 @@ common::duration::duration(const std::chrono::duration<Rep, Period> &d) {
 	this -> create(d);
 }
 
+template<typename Clock>
+common::duration common::duration::since(const std::chrono::time_point<Clock>& start) {
+	return common::duration(Clock::now(), start);
+}
+
 template<typename... Ts>
 std::string common::fmt(const std::string& fmt, Ts... vs) {
 
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+
+// Allocation counting for library functions, enabled by building with
+// -DCOMMON_ALLOC_PROBES (make COMMON_ALLOC_PROBES=1). In this mode library
+// replaces global operator new and delete with counting versions and
+// functions marked with COMMON_ALLOC_PROBE() record calls, allocations and
+// allocated bytes made while they run. Counts are inclusive, allocations of
+// a nested probed function are counted for its caller too.
+//
+// Without the define, COMMON_ALLOC_PROBE() expands to nothing and report()
+// is always empty.
+
+namespace common {
+
+	namespace alloc {
+
+		struct counters {
+			uint64_t allocs = 0;
+			uint64_t bytes = 0;
+		};
+
+		struct stats {
+			const char* name;
+			uint64_t calls;
+			uint64_t allocs;
+			uint64_t bytes;
+		};
+
+		// allocations made by calling thread since it started
+		counters thread_counters();
+
+		// per-function totals of all threads, sorted by allocated bytes
+		std::vector<stats> report();
+		void dump(std::ostream& os);
+		void reset();
+
+#ifdef COMMON_ALLOC_PROBES
+		// static per call site, registered on first use
+		class site {
+
+			friend std::vector<stats> alloc::report();
+			friend void alloc::reset();
+
+			private:
+				const char* name;
+				std::atomic<uint64_t> calls{0};
+				std::atomic<uint64_t> allocs{0};
+				std::atomic<uint64_t> bytes{0};
+				site* next;
+
+			public:
+				site(const char* name);
+				void add(const counters& c);
+		};
+
+		class probe {
+
+			private:
+				alloc::site& s;
+				counters start;
+
+			public:
+				probe(alloc::site& s) : s(s), start(alloc::thread_counters()) {}
+				probe(const probe&) = delete;
+
+				~probe() {
+					counters now = alloc::thread_counters();
+					this -> s.add({ now.allocs - this -> start.allocs, now.bytes - this -> start.bytes });
+				}
+		};
+#endif
+	}
+}
+
+#ifdef COMMON_ALLOC_PROBES
+#define COMMON_ALLOC_PROBE() \
+	static common::alloc::site _common_alloc_site(__PRETTY_FUNCTION__); \
+	common::alloc::probe _common_alloc_probe(_common_alloc_site)
+#else
+#define COMMON_ALLOC_PROBE()
+#endif
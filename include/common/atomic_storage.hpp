@@ -0,0 +1,185 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <ostream>
+#include <type_traits>
+
+#include "common/storage.hpp"
+
+namespace common {
+
+template<typename T>
+class atomic_storage {
+
+	static_assert(std::is_arithmetic<T>::value, "Not an arithmetic type, Storage type must be numeric");
+
+	private:
+
+		std::atomic<T> value;
+
+		template<typename F>
+		T update(F f) {
+			T v = this -> value.load(std::memory_order_relaxed);
+			T n;
+			do {
+				n = f(v);
+			} while ( !this -> value.compare_exchange_weak(v, n, std::memory_order_relaxed));
+			return n;
+		}
+
+		T add(T v) {
+			if constexpr ( std::is_integral<T>::value )
+				return this -> value.fetch_add(v, std::memory_order_relaxed) + v;
+			else return this -> update([v](T c) { return c + v; });
+		}
+
+		T sub(T v) {
+			if constexpr ( std::is_integral<T>::value )
+				return this -> value.fetch_sub(v, std::memory_order_relaxed) - v;
+			else return this -> update([v](T c) { return c - v; });
+		}
+
+	public:
+
+		atomic_storage() : value(0) {}
+		atomic_storage(T v) : value(v) {}
+		atomic_storage(const Storage<T>& s) : value(s.raw()) {}
+		atomic_storage(const atomic_storage&) = delete;
+
+		operator T() const { return this -> load(); }
+		operator Storage<T>() const { return Storage<T>(this -> load()); }
+
+		T load() const { return this -> value.load(std::memory_order_relaxed); }
+		void store(T v) { this -> value.store(v, std::memory_order_relaxed); }
+		T exchange(T v) { return this -> value.exchange(v, std::memory_order_relaxed); }
+
+		atomic_storage& operator =(const T& v) { this -> store(v); return *this; }
+		atomic_storage& operator =(const atomic_storage&) = delete;
+
+		Storage<T> operator +(const T& v) const { return Storage<T>(this -> load() + v); }
+		Storage<T> operator -(const T& v) const { return Storage<T>(this -> load() - v); }
+		Storage<T> operator *(const T& v) const { return Storage<T>(this -> load() * v); }
+		Storage<T> operator /(const T& v) const { return Storage<T>(this -> load() / v); }
+		Storage<T> operator %(const T& v) const { return Storage<T>(this -> load() % v); }
+
+		atomic_storage& operator +=(const T& v) { this -> add(v); return *this; }
+		atomic_storage& operator -=(const T& v) { this -> sub(v); return *this; }
+		atomic_storage& operator *=(const T& v) { this -> update([v](T c) { return c * v; }); return *this; }
+		atomic_storage& operator /=(const T& v) { this -> update([v](T c) { return c / v; }); return *this; }
+		atomic_storage& operator %=(const T& v) { this -> update([v](T c) { return c % v; }); return *this; }
+
+		T operator ++() { return this -> add(1); }
+		T operator --() { return this -> sub(1); }
+		T operator ++(int) { return this -> add(1) - 1; }
+		T operator --(int) { return this -> sub(1) + 1; }
+
+		bool operator ==(const T& v) const { return this -> load() == v; }
+		bool operator !=(const T& v) const { return this -> load() != v; }
+		bool operator <(const T& v) const { return this -> load() < v; }
+		bool operator >(const T& v) const { return this -> load() > v; }
+		bool operator <=(const T& v) const { return this -> load() <= v; }
+		bool operator >=(const T& v) const { return this -> load() >= v; }
+
+		T raw() const { return this -> load(); }
+
+		T kb() const { return this -> load(); }
+		T mb() const { return Storage<T>(this -> load()).mb(); }
+		T gb() const { return Storage<T>(this -> load()).gb(); }
+};
+
+// Counter spread over cache line sized cells, each thread updates its own
+// cell and reads sum all of them. Updates never contend as long as there are
+// no more concurrently updating threads than shards; reads are O(Shards) and
+// not a snapshot across cells.
+template<typename T, size_t Shards = 32>
+class sharded_storage {
+
+	static_assert(std::is_integral<T>::value, "Not an integral type, sharded_storage type must be integer");
+	static_assert(Shards > 0, "sharded_storage needs at least one shard");
+
+	private:
+
+		struct alignas(64) cell {
+			std::atomic<T> value{0};
+		};
+
+		cell cells[Shards];
+
+		static size_t shard() {
+			static std::atomic<size_t> next{0};
+			thread_local size_t index = next.fetch_add(1, std::memory_order_relaxed) % Shards;
+			return index;
+		}
+
+		std::atomic<T>& local() { return this -> cells[sharded_storage::shard()].value; }
+
+	public:
+
+		sharded_storage() {}
+		sharded_storage(T v) { this -> cells[0].value.store(v, std::memory_order_relaxed); }
+		sharded_storage(const sharded_storage&) = delete;
+
+		operator T() const { return this -> load(); }
+		operator Storage<T>() const { return Storage<T>(this -> load()); }
+
+		T load() const {
+			T sum = 0;
+			for ( const cell& c : this -> cells )
+				sum += c.value.load(std::memory_order_relaxed);
+			return sum;
+		}
+
+		// not atomic with respect to concurrent updates
+		void store(T v) {
+			for ( cell& c : this -> cells )
+				c.value.store(0, std::memory_order_relaxed);
+			this -> cells[0].value.store(v, std::memory_order_relaxed);
+		}
+
+		sharded_storage& operator =(const T& v) { this -> store(v); return *this; }
+		sharded_storage& operator =(const sharded_storage&) = delete;
+
+		Storage<T> operator +(const T& v) const { return Storage<T>(this -> load() + v); }
+		Storage<T> operator -(const T& v) const { return Storage<T>(this -> load() - v); }
+		Storage<T> operator *(const T& v) const { return Storage<T>(this -> load() * v); }
+		Storage<T> operator /(const T& v) const { return Storage<T>(this -> load() / v); }
+		Storage<T> operator %(const T& v) const { return Storage<T>(this -> load() % v); }
+
+		sharded_storage& operator +=(const T& v) { this -> local().fetch_add(v, std::memory_order_relaxed); return *this; }
+		sharded_storage& operator -=(const T& v) { this -> local().fetch_sub(v, std::memory_order_relaxed); return *this; }
+
+		void operator ++() { this -> local().fetch_add(1, std::memory_order_relaxed); }
+		void operator --() { this -> local().fetch_sub(1, std::memory_order_relaxed); }
+		void operator ++(int) { this -> local().fetch_add(1, std::memory_order_relaxed); }
+		void operator --(int) { this -> local().fetch_sub(1, std::memory_order_relaxed); }
+
+		bool operator ==(const T& v) const { return this -> load() == v; }
+		bool operator !=(const T& v) const { return this -> load() != v; }
+		bool operator <(const T& v) const { return this -> load() < v; }
+		bool operator >(const T& v) const { return this -> load() > v; }
+		bool operator <=(const T& v) const { return this -> load() <= v; }
+		bool operator >=(const T& v) const { return this -> load() >= v; }
+
+		T raw() const { return this -> load(); }
+
+		T kb() const { return this -> load(); }
+		T mb() const { return Storage<T>(this -> load()).mb(); }
+		T gb() const { return Storage<T>(this -> load()).gb(); }
+};
+
+} // end of namespace
+
+template<typename T>
+std::ostream& operator <<(std::ostream& os, const common::atomic_storage<T>& s) {
+
+	os << s.load();
+	return os;
+}
+
+template<typename T, size_t Shards>
+std::ostream& operator <<(std::ostream& os, const common::sharded_storage<T, Shards>& s) {
+
+	os << s.load();
+	return os;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <memory>
+#include <cstddef>
+#include <cstdint>
+
+namespace common {
+
+	// Reads many small files with a handful of syscalls. Files are queued
+	// with add() and read by submit(): with io_uring, opens, reads and
+	// closes of up to depth files are each submitted as one batch, without
+	// it (old kernel, io_uring disabled by seccomp or sysctl) files are read
+	// with openat + pread + close. Buffers are kept between batches, clear()
+	// only forgets queued files.
+	class batch_reader {
+
+		public:
+
+			batch_reader(unsigned depth = 256, bool use_io_uring = true);
+			batch_reader(const batch_reader&) = delete;
+			batch_reader& operator =(const batch_reader&) = delete;
+			~batch_reader();
+
+			// queue file by path, or an already open descriptor that is
+			// read from offset 0 and not closed. size_hint is initial
+			// buffer size, buffer grows when file does not fit.
+			size_t add(const std::string& path, size_t size_hint = 4096);
+			size_t add_fd(int fd, size_t size_hint = 4096);
+
+			void submit();
+			void clear();
+
+			size_t size() const { return this -> used; }
+
+			// contents of i'th file after submit(), empty on error
+			std::string_view data(size_t i) const;
+			std::string str(size_t i) const { return std::string(this -> data(i)); }
+
+			// errno of failed open or read, 0 on success
+			int error(size_t i) const { return this -> files[i].error; }
+
+			bool using_io_uring() const { return this -> ring != nullptr; }
+
+		private:
+
+			struct file {
+				std::string path;
+				int fd = -1;
+				bool owned = true;
+				size_t length = 0;
+				int error = 0;
+				std::vector<char> buf;
+			};
+
+			struct uring;
+
+			unsigned depth;
+			std::vector<std::vector<char>> retired; // buffers a failed ring may still write, outlive ring
+			std::unique_ptr<uring> ring;
+			std::vector<file> files;
+			size_t used = 0; // files in use, files beyond this are pooled buffers
+			bool unsupported = false;
+
+			void read_sync(file& f);
+			void grow(file& f);
+			void complete(uint64_t data, int res);
+			bool abandon_ring(size_t first, size_t last);
+			bool submit_ring(size_t first, size_t last);
+	};
+}
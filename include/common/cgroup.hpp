@@ -0,0 +1,105 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace common {
+
+	// Reads statistics files (cpu.stat, memory.stat, io.stat, ...) of every
+	// cgroup of a cgroup v2 hierarchy. Counters are stored column-wise, one
+	// column per file and key, one row per cgroup; io.stat's per device
+	// "key=value" counters are summed over devices. Up to max_open files,
+	// at most a quarter of descriptor limit, are kept open between samples
+	// and read with pread, others are opened per sample; keys are matched
+	// against order of previous row first, so a sample allocates only when
+	// new cgroups or keys show up. A file that cannot be opened for lack of
+	// descriptors keeps its previous values and is retried next sample.
+	class cgroup_reader {
+
+		public:
+
+			cgroup_reader(const std::string& root = "/sys/fs/cgroup",
+				const std::vector<std::string>& files = { "cpu.stat", "memory.stat", "io.stat" },
+				size_t max_open = 256);
+			cgroup_reader(const cgroup_reader&) = delete;
+			cgroup_reader& operator =(const cgroup_reader&) = delete;
+			~cgroup_reader();
+
+			// walks the hierarchy again, adds new cgroups and drops removed ones
+			void rescan();
+
+			// reads every file of every cgroup, first sample rescans
+			void sample();
+
+			size_t size() const { return this -> rows.size(); }
+
+			// cgroup path relative to root, "/" for root itself
+			const std::string& path(size_t row) const { return this -> rows[row].path; }
+			ssize_t find(std::string_view path) const;
+
+			// column of key in file, -1 when not seen yet
+			ssize_t column(std::string_view file, std::string_view key) const;
+			size_t columns() const { return this -> cols.size(); }
+			const std::string& column_file(size_t column) const { return this -> files[this -> cols[column].file]; }
+			const std::string& column_key(size_t column) const { return this -> cols[column].key; }
+
+			// current values in the file's own unit: bytes in memory.stat,
+			// memory.current and io.stat's *bytes keys, microseconds in
+			// cpu.stat's *_usec keys, plain counts otherwise; 0 for cgroups
+			// without the key
+			const std::vector<uint64_t>& values(size_t column) const { return this -> cols[column].values; }
+			uint64_t value(size_t column, size_t row) const { return this -> cols[column].values[row]; }
+
+			// change since previous sample, 0 for cgroups seen first time
+			long long delta(size_t column, size_t row) const;
+
+			std::chrono::nanoseconds interval() const { return this -> elapsed; }
+			size_t open_files() const { return this -> persistent; }
+
+		private:
+
+			struct row {
+				std::string path;
+				std::vector<int> fds; // per file, -1 when not kept open, -2 when file does not exist
+				uint32_t generation = 0;
+				bool fresh = true;
+				bool gone = false;
+			};
+
+			struct col {
+				size_t file;
+				std::string key;
+				std::vector<uint64_t> values;
+				std::vector<uint64_t> previous;
+				bool fresh = true;
+			};
+
+			std::string root;
+			std::vector<std::string> files;
+			std::vector<row> rows;
+			std::vector<col> cols;
+			std::vector<std::vector<size_t>> file_cols; // columns of each file in order seen
+			std::unordered_map<std::string, size_t> index; // path to row
+			std::vector<char> buf;
+
+			int root_fd = -1;
+			size_t fd_budget;
+			size_t persistent = 0;
+			uint32_t generation = 0;
+			uint32_t samples = 0;
+			std::chrono::steady_clock::time_point last;
+			std::chrono::nanoseconds elapsed{0};
+
+			void walk(int dir_fd, const std::string& path);
+			void close_row(row& r);
+			ssize_t read_file(row& r, size_t file, bool& retry);
+			size_t column_for(size_t file, std::string_view key, size_t& hint);
+			void parse(size_t file, size_t row, size_t len);
+			void remove_gone();
+	};
+}
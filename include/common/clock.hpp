@@ -0,0 +1,138 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace common {
+
+	// std::chrono compatible clocks, usable with common::duration and
+	// std::chrono::duration_cast. All of them are steady, unlike
+	// system_clock used by get_millis they do not jump with wall clock.
+	namespace clock {
+
+		// CLOCK_MONOTONIC, nanosecond resolution, served from vDSO
+		struct monotonic {
+
+			using duration = std::chrono::nanoseconds;
+			using rep = duration::rep;
+			using period = duration::period;
+			using time_point = std::chrono::time_point<monotonic>;
+			static constexpr bool is_steady = true;
+
+			static time_point now() noexcept {
+				struct timespec ts;
+				::clock_gettime(CLOCK_MONOTONIC, &ts);
+				return time_point(duration((rep)ts.tv_sec * 1000000000 + ts.tv_nsec));
+			}
+		};
+
+		// CLOCK_MONOTONIC_COARSE, cheapest kernel clock, resolution is a
+		// timer tick (1-10ms), see resolution()
+		struct coarse {
+
+			using duration = std::chrono::nanoseconds;
+			using rep = duration::rep;
+			using period = duration::period;
+			using time_point = std::chrono::time_point<coarse>;
+			static constexpr bool is_steady = true;
+
+			static time_point now() noexcept {
+				struct timespec ts;
+				::clock_gettime(CLOCK_MONOTONIC_COARSE, &ts);
+				return time_point(duration((rep)ts.tv_sec * 1000000000 + ts.tv_nsec));
+			}
+
+			static duration resolution() noexcept;
+		};
+
+		// cycle counter calibrated against monotonic clock on first use. Needs
+		// an invariant TSC, elsewhere (or on other architectures) reading
+		// falls back to monotonic clock, see available(). Time points are
+		// comparable with monotonic ones, drift between them is not corrected.
+		struct tsc {
+
+			using duration = std::chrono::nanoseconds;
+			using rep = duration::rep;
+			using period = duration::period;
+			using time_point = std::chrono::time_point<tsc>;
+			static constexpr bool is_steady = true;
+
+			struct calibration {
+				bool available;
+				uint64_t base_cycles;
+				int64_t base_ns;
+				uint64_t mult; // ns per cycle, 32.32 fixed point
+			};
+
+			static const calibration& params() noexcept {
+				static const calibration c = tsc::calibrate();
+				return c;
+			}
+
+			static bool available() noexcept { return tsc::params().available; }
+
+			// counter readings for to_duration(), steady_clock nanoseconds
+			// when TSC is not available
+			static uint64_t cycles() noexcept {
+
+				if ( !tsc::params().available )
+					return std::chrono::duration_cast<duration>(std::chrono::steady_clock::now().time_since_epoch()).count();
+
+				return tsc::raw_cycles();
+			}
+
+			static time_point now() noexcept {
+
+				const calibration& c = tsc::params();
+
+				if ( !c.available )
+					return time_point(monotonic::now().time_since_epoch());
+
+				// signed, TSC of another core may read slightly below base
+				__int128 ns = (__int128)(int64_t)( tsc::raw_cycles() - c.base_cycles ) * (__int128)c.mult;
+				return time_point(duration(c.base_ns + (int64_t)( ns >> 32 )));
+			}
+
+			// converts difference of two cycles() readings; a negative one,
+			// when thread moved to a core whose TSC lags, is 0
+			static duration to_duration(uint64_t cycles) noexcept {
+
+				if ((int64_t)cycles < 0 )
+					return duration(0);
+
+				const calibration& c = tsc::params();
+				return c.available ? duration((int64_t)(((unsigned __int128)cycles * c.mult ) >> 32 )) : duration(cycles);
+			}
+
+			// cycles per second found by calibration, 0 if not available
+			static double frequency() noexcept;
+
+			private:
+				static calibration calibrate() noexcept;
+
+				static uint64_t raw_cycles() noexcept {
+#if defined(__x86_64__) || defined(__i386__)
+					return __rdtsc();
+#else
+					return monotonic::now().time_since_epoch().count();
+#endif
+				}
+		};
+
+		// time elapsed since start, in clock's native resolution
+		template<typename Clock, typename Duration>
+		inline Duration elapsed(const std::chrono::time_point<Clock, Duration>& start) noexcept {
+			return Clock::now() - start;
+		}
+
+		// steady millisecond counter, monotonic counterpart of get_millis
+		inline std::chrono::milliseconds millis() noexcept {
+			return std::chrono::duration_cast<std::chrono::milliseconds>(monotonic::now().time_since_epoch());
+		}
+	}
+}
@@ -28,44 +28,217 @@
 #include <type_traits>
 #include <cstddef>
 #include <utility>
+#include <iterator>
+#include <vector>
 
 namespace common {
 
+	// iterator pairing position with element. It has the category of the
+	// wrapped iterator, so over random access containers it is random access
+	// itself and can be used with parallel algorithms and chunked loops.
+	template <typename iterator_type, typename reference_type>
+	struct enumerate_iterator {
+
+		using iterator_category = typename std::iterator_traits<iterator_type>::iterator_category;
+		using difference_type = typename std::iterator_traits<iterator_type>::difference_type;
+		using value_type = std::pair<size_t, reference_type>;
+		using reference = value_type;
+		using pointer = void;
+
+		size_t index;
+		iterator_type value;
+
+		constexpr bool operator==(const enumerate_iterator& other) const {
+			return value == other.value;
+		}
+
+		constexpr bool operator!=(const enumerate_iterator& other) const {
+			return value != other.value;
+		}
+
+		constexpr bool operator!=(const iterator_type& other) const {
+			return value != other;
+		}
+
+		constexpr enumerate_iterator& operator++() {
+			++index;
+			++value;
+			return *this;
+		}
+
+		constexpr enumerate_iterator operator++(int) {
+			enumerate_iterator tmp = *this;
+			++*this;
+			return tmp;
+		}
+
+		constexpr enumerate_iterator& operator--() {
+			--index;
+			--value;
+			return *this;
+		}
+
+		constexpr enumerate_iterator operator--(int) {
+			enumerate_iterator tmp = *this;
+			--*this;
+			return tmp;
+		}
+
+		constexpr std::pair<size_t, reference_type> operator*() const {
+			return std::pair<size_t, reference_type>{index, *value};
+		}
+
+		// random access, only usable when iterator_type is random access
+
+		constexpr enumerate_iterator& operator+=(difference_type n) {
+			index += n;
+			value += n;
+			return *this;
+		}
+
+		constexpr enumerate_iterator& operator-=(difference_type n) {
+			index -= n;
+			value -= n;
+			return *this;
+		}
+
+		constexpr enumerate_iterator operator+(difference_type n) const {
+			return enumerate_iterator{index + n, value + n};
+		}
+
+		constexpr enumerate_iterator operator-(difference_type n) const {
+			return enumerate_iterator{index - n, value - n};
+		}
+
+		constexpr difference_type operator-(const enumerate_iterator& other) const {
+			return value - other.value;
+		}
+
+		constexpr std::pair<size_t, reference_type> operator[](difference_type n) const {
+			return std::pair<size_t, reference_type>{index + n, value[n]};
+		}
+
+		constexpr bool operator<(const enumerate_iterator& other) const { return value < other.value; }
+		constexpr bool operator>(const enumerate_iterator& other) const { return value > other.value; }
+		constexpr bool operator<=(const enumerate_iterator& other) const { return value <= other.value; }
+		constexpr bool operator>=(const enumerate_iterator& other) const { return value >= other.value; }
+
+		friend constexpr enumerate_iterator operator+(difference_type n, const enumerate_iterator& it) {
+			return it + n;
+		}
+	};
+
+	// sub-range of an enumeration, indexes stay aligned with the whole container
+	template <typename iterator_type, typename reference_type>
+	struct enumerate_range {
+
+		using iterator = enumerate_iterator<iterator_type, reference_type>;
+
+		iterator first;
+		iterator last;
+
+		constexpr iterator begin() const { return first; }
+		constexpr iterator end() const { return last; }
+		constexpr size_t size() const { return last.index - first.index; }
+		constexpr bool empty() const { return first == last; }
+	};
+
+	template <typename container_type, typename = void>
+	struct enumerate_has_size : std::false_type {};
+
+	template <typename container_type>
+	struct enumerate_has_size<container_type, std::void_t<decltype(std::declval<container_type&>().size())>> : std::true_type {};
+
 	template <typename container_type>
 	struct enumerate_wrapper {
 
 		using iterator_type = std::conditional_t<std::is_const_v<container_type>, typename container_type::const_iterator, typename container_type::iterator>;
 		using pointer_type = std::conditional_t<std::is_const_v<container_type>, typename container_type::const_pointer, typename container_type::pointer>;
 		using reference_type = std::conditional_t<std::is_const_v<container_type>, typename container_type::const_reference, typename container_type::reference>;
+		using enumerate_wrapper_iter = enumerate_iterator<iterator_type, reference_type>;
+		using range_type = enumerate_range<iterator_type, reference_type>;
 
 		constexpr enumerate_wrapper(container_type& c): container(c) {}
 
-		struct enumerate_wrapper_iter {
+		constexpr enumerate_wrapper_iter begin() {
+			return {0, std::begin(container)};
+		}
 
-			size_t index;
-			iterator_type value;
+		// end's index is only meaningful for sized containers, iterators
+		// are compared by position so it doesn't affect iteration
+		constexpr enumerate_wrapper_iter end() {
+			if constexpr ( enumerate_has_size<container_type>::value )
+				return {size(), std::end(container)};
+			else return {0, std::end(container)};
+		}
 
-			constexpr bool operator!=(const iterator_type& other) const {
-				return value != other;
-			}
+		constexpr size_t size() const {
+			if constexpr ( enumerate_has_size<container_type>::value )
+				return container.size();
+			else return std::distance(std::begin(container), std::end(container));
+		}
 
-			constexpr enumerate_wrapper_iter& operator++() {
-				++index;
-				++value;
-				return *this;
-			}
+		// elements [from, to) with their indexes in the container
+		constexpr range_type range(size_t from, size_t to) {
+			auto first = std::next(std::begin(container), from);
+			return range_type{{from, first}, {to, std::next(first, to - from)}};
+		}
 
-			constexpr std::pair<size_t, reference_type> operator*() {
-				return std::pair<size_t, reference_type>{index, *value};
-			}
-		};
+		// consecutive ranges of at most chunk_size elements
+		std::vector<range_type> chunks(size_t chunk_size) {
 
-		constexpr enumerate_wrapper_iter begin() {
-			return {0, std::begin(container)};
+			size_t n = size();
+
+			if ( chunk_size == 0 )
+				chunk_size = 1;
+
+			return ranges(( n + chunk_size - 1 ) / chunk_size, [chunk_size, n](size_t from) {
+				return from + chunk_size < n ? chunk_size : n - from;
+			});
 		}
 
-		constexpr iterator_type end() {
-			return std::end(container);
+		// parts ranges of near equal size, first n % parts of them one
+		// element longer; fewer, single element, ranges when n < parts.
+		// Useful for giving each thread its share.
+		std::vector<range_type> split(size_t parts) {
+
+			size_t n = size();
+
+			if ( parts == 0 )
+				parts = 1;
+
+			size_t base = n / parts;
+			size_t extra = n % parts;
+			size_t count = base == 0 ? extra : parts;
+			size_t part = 0;
+
+			return ranges(count, [base, extra, &part](size_t) {
+				return base + ( part++ < extra ? 1 : 0 );
+			});
+		}
+
+		// count ranges, length of each from length_of(start index); walks
+		// the container once, so chunking list-like containers is linear
+		template <typename F>
+		std::vector<range_type> ranges(size_t count, F length_of) {
+
+			std::vector<range_type> vec;
+			vec.reserve(count);
+
+			auto it = std::begin(container);
+			size_t from = 0;
+
+			for ( size_t i = 0; i < count; i++ ) {
+
+				size_t len = length_of(from);
+				auto next = std::next(it, len);
+
+				vec.push_back(range_type{{from, it}, {from + len, next}});
+				it = next;
+				from += len;
+			}
+
+			return vec;
 		}
 
 		container_type& container;
@@ -0,0 +1,121 @@
+#pragma once
+
+#include <array>
+#include <string_view>
+#include <charconv>
+#include <cstdint>
+#include <cstddef>
+
+#include "common/storage.hpp"
+
+namespace common {
+
+	// Compile-time perfect hash from "Key:" names of /proc style files to
+	// Storage<unsigned long> members of S. Seed and slots are searched by
+	// the constexpr constructor, a table that can not be built fails to
+	// compile. Lookups hash the key once and compare one name.
+	template<typename S, size_t N>
+	class field_table {
+
+		public:
+
+			struct field {
+				std::string_view name;
+				Storage<unsigned long> S::* member;
+			};
+
+			static constexpr size_t slot_count = [] {
+				size_t n = 1;
+				while ( n < N * 2 ) n <<= 1;
+				return n;
+			}();
+
+			static_assert(N < 255, "field_table supports up to 254 fields");
+
+			constexpr field_table(const std::array<field, N>& fields) : fields(fields), seed(0), slots{} {
+
+				for ( uint32_t s = 1; s < 100000; s++ ) {
+
+					std::array<uint8_t, slot_count> t{};
+					bool ok = true;
+
+					for ( size_t i = 0; i < N && ok; i++ ) {
+						size_t h = field_table::hash(fields[i].name, s) & ( slot_count - 1 );
+						if ( t[h] != 0 ) ok = false;
+						else t[h] = i + 1;
+					}
+
+					if ( ok ) {
+						this -> seed = s;
+						this -> slots = t;
+						return;
+					}
+				}
+
+				throw "field_table: no perfect hash seed found";
+			}
+
+			constexpr const field* find(std::string_view key) const {
+
+				uint8_t i = this -> slots[field_table::hash(key, this -> seed) & ( slot_count - 1 )];
+				return i != 0 && this -> fields[i - 1].name == key ? &this -> fields[i - 1] : nullptr;
+			}
+
+			// decodes "Key:   1234 kB" lines of data into out, unknown keys
+			// and non-numeric values are skipped. out is reset first, so
+			// fields missing from data are 0 also when out is reused. kB
+			// values are stored as kB, the unit of Storage, other numbers as
+			// they are. Returns count of decoded fields.
+			size_t decode(std::string_view data, S& out) const {
+
+				out = S{};
+				size_t count = 0;
+				const char* p = data.data();
+				const char* end = p + data.size();
+
+				while ( p < end ) {
+
+					const char* eol = p;
+					while ( eol < end && *eol != '\n' ) eol++;
+
+					const char* colon = p;
+					while ( colon < eol && *colon != ':' ) colon++;
+
+					if ( colon < eol ) {
+
+						if ( const field* f = this -> find(std::string_view(p, colon - p))) {
+
+							const char* v = colon + 1;
+							while ( v < eol && ( *v == ' ' || *v == '\t' )) v++;
+
+							unsigned long n;
+							if ( std::from_chars(v, eol, n).ec == std::errc()) {
+								out.*(f -> member) = n;
+								count++;
+							}
+						}
+					}
+
+					p = eol + 1;
+				}
+
+				return count;
+			}
+
+		private:
+
+			std::array<field, N> fields;
+			uint32_t seed;
+			std::array<uint8_t, slot_count> slots;
+
+			static constexpr uint32_t hash(std::string_view s, uint32_t seed) {
+
+				uint32_t h = 2166136261u ^ seed;
+
+				for ( char ch : s )
+					h = ( h ^ (uint8_t)ch ) * 16777619u;
+
+				return h ^ ( h >> 15 );
+			}
+	};
+}
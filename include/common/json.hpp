@@ -0,0 +1,89 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <utility>
+#include <cstddef>
+#include <memory_resource>
+
+#include "rva/variant.hpp"
+#include "rva/arena.hpp"
+
+namespace common {
+
+	namespace json {
+
+		using value = rva::variant<std::nullptr_t, bool, double, std::string_view,
+			std::vector<rva::self_t>, std::vector<std::pair<std::string_view, rva::self_t>>>;
+		using array = std::vector<value>;
+		using object = std::vector<std::pair<std::string_view, value>>;
+
+		// same tree with containers allocating from an rva::arena; copies
+		// allocate from the default resource, see rva::arena::copy
+		namespace pmr {
+
+			using value = rva::variant<std::nullptr_t, bool, double, std::string_view,
+				std::pmr::vector<rva::self_t>, std::pmr::vector<std::pair<std::string_view, rva::self_t>>>;
+			using array = std::pmr::vector<value>;
+			using object = std::pmr::vector<std::pair<std::string_view, value>>;
+		}
+
+		enum class type { null, boolean, number, string, array, object };
+
+		// Single pass, in-situ parser. Strings are views into buf, escaped
+		// strings are unescaped in place, so buf is modified and must outlive
+		// the returned value. Errors throw std::runtime_error.
+		value parse(char* buf, size_t size);
+		value parse(std::string& buf);
+
+		// parses into arena, a document's many small arrays and objects
+		// come from one buffer and are freed together by arena.release(),
+		// which may happen only after the returned tree is destroyed
+		pmr::value parse(char* buf, size_t size, rva::arena& arena);
+		pmr::value parse(std::string& buf, rva::arena& arena);
+
+		json::type type_of(const value& v);
+		json::type type_of(const pmr::value& v);
+		const value* find(const object& o, std::string_view key);
+		const pmr::value* find(const pmr::object& o, std::string_view key);
+
+		// On-demand access to a document without building a tree. Values are
+		// located by skipping over their siblings when asked for; buf is not
+		// modified and must outlive every lazy obtained from it.
+		class lazy {
+
+			private:
+				const char* p;
+				const char* end;
+
+				lazy(const char* p, const char* end, bool) : p(p), end(end) {}
+
+				const char* value_end() const;
+
+			public:
+
+				lazy(const char* data, size_t size);
+				lazy(const std::string& buf);
+				// would view a temporary that is gone before first access
+				lazy(std::string&& buf) = delete;
+
+				json::type type() const;
+				bool is_null() const;
+				bool boolean() const;
+				double number() const;
+				std::string string() const;
+
+				// raw text of value, including quotes for strings
+				std::string_view raw() const;
+
+				size_t size() const;
+				bool contains(std::string_view key) const;
+				lazy operator [](std::string_view key) const;
+				lazy operator [](size_t index) const;
+
+				// copies value's text into storage and parses it
+				json::value materialize(std::string& storage) const;
+		};
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "common/json.hpp"
+
+namespace common {
+
+	namespace json {
+
+		// Flattened, read-only copy of a json::value. Nodes are stored in
+		// depth-first order in one array, every node knows the length of its
+		// subtree, so siblings are skipped without visiting their children.
+		// Object members are stored as a key string node followed by the
+		// value. String contents live in a single pool.
+		class tape {
+
+			public:
+
+				struct node {
+					json::type type;
+					uint32_t span; // nodes in subtree, including this one
+					union {
+						bool boolean;
+						double number;
+						uint32_t count; // array elements or object members
+						struct { uint32_t offset, length; } string;
+					};
+				};
+
+				class ref;
+
+				// walks elements of an array or values of an object members,
+				// key() gives name of current object member
+				class iterator {
+
+					friend class ref;
+
+					private:
+						const json::tape* t;
+						uint32_t i;
+						bool object;
+
+						iterator(const json::tape* t, uint32_t i, bool object) : t(t), i(i), object(object) {}
+
+					public:
+
+						bool operator ==(const iterator& other) const { return this -> i == other.i; }
+						bool operator !=(const iterator& other) const { return this -> i != other.i; }
+
+						iterator& operator ++() {
+							this -> i += this -> object ? 1 + this -> t -> nodes[this -> i + 1].span : this -> t -> nodes[this -> i].span;
+							return *this;
+						}
+
+						ref operator *() const;
+						std::string_view key() const;
+				};
+
+				class ref {
+
+					friend class tape;
+					friend class iterator;
+
+					private:
+						const json::tape* t;
+						uint32_t i;
+
+						ref(const json::tape* t, uint32_t i) : t(t), i(i) {}
+
+						const node& n() const { return this -> t -> nodes[this -> i]; }
+						uint32_t child(size_t index) const;
+
+					public:
+
+						json::type type() const { return this -> n().type; }
+						bool is_null() const { return this -> n().type == json::type::null; }
+						bool boolean() const;
+						double number() const;
+						std::string_view string() const;
+
+						// elements in array, members in object, 0 for others
+						size_t size() const;
+						bool contains(std::string_view key) const;
+						std::string_view key(size_t index) const;
+						ref value(size_t index) const;
+						ref operator [](std::string_view key) const;
+						ref operator [](size_t index) const;
+
+						iterator begin() const;
+						iterator end() const;
+				};
+
+				tape() = default;
+				tape(const json::value& v);
+
+				ref root() const;
+				bool empty() const { return this -> nodes.empty(); }
+
+				// rebuilds a tree, strings of result are views into this tape
+				json::value to_value() const;
+
+				const std::vector<node>& data() const { return this -> nodes; }
+				const std::string& strings() const { return this -> pool; }
+				size_t memory_usage() const;
+
+			private:
+				std::vector<node> nodes;
+				std::string pool;
+
+				void append(const json::value& v);
+				void append_string(std::string_view s);
+				json::value value_at(uint32_t& i) const;
+		};
+	}
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+#include <array>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "common/clock.hpp"
+
+// Scoped latency probes. COMMON_LATENCY_PROBE("name") times rest of the
+// enclosing scope with common::clock::tsc, steady_clock where TSC is not
+// usable, and records nanoseconds into a histogram of the calling thread;
+// recording takes no locks and does no atomic read-modify-write. Histograms
+// are log-linear (HDR style): values are exact below 64ns and within 1/32
+// (~3%) above, up to 2^40ns (~18min).
+// Reading merges histograms of all threads, including exited ones, whose
+// histograms are taken over by next new threads recording at same probe.
+
+namespace common {
+
+	namespace latency {
+
+		constexpr unsigned sub_bits = 5;
+		constexpr unsigned max_bits = 40;
+		constexpr size_t bucket_count = ( max_bits - sub_bits + 1 ) << sub_bits;
+
+		constexpr size_t bucket(uint64_t v) {
+
+			if ( v >= ( 1ULL << max_bits ))
+				v = ( 1ULL << max_bits ) - 1;
+
+			if ( v < ( 1ULL << sub_bits ))
+				return v;
+
+			unsigned shift = 63 - __builtin_clzll(v) - sub_bits;
+			return (( shift + 1 ) << sub_bits ) + ( v >> shift ) - ( 1ULL << sub_bits );
+		}
+
+		// highest value that maps to bucket i
+		constexpr uint64_t bucket_max(size_t i) {
+
+			if ( i < ( 1ULL << sub_bits ))
+				return i;
+
+			unsigned shift = ( i >> sub_bits ) - 1;
+			uint64_t sub = ( i & (( 1ULL << sub_bits ) - 1 )) + ( 1ULL << sub_bits );
+			return ( sub << shift ) + ( 1ULL << shift ) - 1;
+		}
+
+		// merged result of one probe
+		class histogram {
+
+			public:
+
+				std::array<uint64_t, bucket_count> counts{};
+				uint64_t count = 0;
+				uint64_t sum = 0;
+				uint64_t min = 0;
+				uint64_t max = 0;
+
+				void record(uint64_t ns);
+				void merge(const histogram& other);
+
+				double mean() const { return this -> count == 0 ? 0 : (double)this -> sum / this -> count; }
+
+				// value at or below which p percent of recorded values are, p in 0 - 100
+				uint64_t percentile(double p) const;
+		};
+
+		// per call site, registered on first use
+		class site {
+
+			private:
+				const char* name;
+				size_t id;
+
+			public:
+				site(const char* name);
+				void record(uint64_t ns);
+				const char* label() const { return this -> name; }
+		};
+
+		class probe {
+
+			private:
+				latency::site& s;
+				uint64_t start;
+
+			public:
+				probe(latency::site& s) : s(s), start(common::clock::tsc::cycles()) {}
+				probe(const probe&) = delete;
+
+				~probe() {
+					this -> s.record(common::clock::tsc::to_duration(common::clock::tsc::cycles() - this -> start).count());
+				}
+		};
+
+		struct result {
+			const char* name;
+			histogram hist;
+		};
+
+		// all threads merged, empty histogram when probe has not run
+		histogram read(std::string_view name);
+		std::vector<result> report();
+
+		// count, mean, p50, p90, p99, p99.9 and max of each probe
+		void dump(std::ostream& os);
+
+		// zeroes all histograms; values recorded concurrently may survive
+		void reset();
+	}
+}
+
+#define COMMON_LATENCY_PROBE(name) \
+	static common::latency::site _common_latency_site(name); \
+	common::latency::probe _common_latency_probe(_common_latency_site)
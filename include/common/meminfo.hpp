@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string_view>
+#include <sys/types.h>
+
+#include "common/storage.hpp"
+
+namespace common {
+
+	// Fixed schema decoders of /proc/meminfo and /proc/[pid]/status. Known
+	// keys are mapped to fields with a compile-time perfect hash table and
+	// numbers are parsed straight into them, unknown keys are skipped.
+	// Decoding allocates nothing, nor does reading files of up to 8 KiB;
+	// larger ones are read whole. Sizes are in kB, like in the files and
+	// Storage, fields missing from file stay 0.
+
+	struct meminfo {
+
+		Storage<unsigned long> total = 0;
+		Storage<unsigned long> free = 0;
+		Storage<unsigned long> available = 0;
+		Storage<unsigned long> buffers = 0;
+		Storage<unsigned long> cached = 0;
+		Storage<unsigned long> swap_cached = 0;
+		Storage<unsigned long> active = 0;
+		Storage<unsigned long> inactive = 0;
+		Storage<unsigned long> active_anon = 0;
+		Storage<unsigned long> inactive_anon = 0;
+		Storage<unsigned long> active_file = 0;
+		Storage<unsigned long> inactive_file = 0;
+		Storage<unsigned long> unevictable = 0;
+		Storage<unsigned long> mlocked = 0;
+		Storage<unsigned long> swap_total = 0;
+		Storage<unsigned long> swap_free = 0;
+		Storage<unsigned long> dirty = 0;
+		Storage<unsigned long> writeback = 0;
+		Storage<unsigned long> anon_pages = 0;
+		Storage<unsigned long> mapped = 0;
+		Storage<unsigned long> shmem = 0;
+		Storage<unsigned long> kreclaimable = 0;
+		Storage<unsigned long> slab = 0;
+		Storage<unsigned long> sreclaimable = 0;
+		Storage<unsigned long> sunreclaim = 0;
+		Storage<unsigned long> kernel_stack = 0;
+		Storage<unsigned long> page_tables = 0;
+		Storage<unsigned long> commit_limit = 0;
+		Storage<unsigned long> committed_as = 0;
+		Storage<unsigned long> vmalloc_total = 0;
+		Storage<unsigned long> vmalloc_used = 0;
+		Storage<unsigned long> anon_huge_pages = 0;
+		Storage<unsigned long> huge_pages_total = 0; // count
+		Storage<unsigned long> huge_pages_free = 0; // count
+		Storage<unsigned long> hugepagesize = 0;
+
+		// returns count of decoded fields
+		size_t decode(std::string_view data);
+		bool read(const char* path = "/proc/meminfo");
+
+		// total - available, or total - free - buffers - cached on kernels
+		// without MemAvailable
+		unsigned long used() const;
+	};
+
+	struct proc_status {
+
+		Storage<unsigned long> pid = 0;
+		Storage<unsigned long> ppid = 0;
+		Storage<unsigned long> uid = 0; // real uid
+		Storage<unsigned long> gid = 0; // real gid
+		Storage<unsigned long> threads = 0;
+		Storage<unsigned long> vm_peak = 0;
+		Storage<unsigned long> vm_size = 0;
+		Storage<unsigned long> vm_lck = 0;
+		Storage<unsigned long> vm_hwm = 0;
+		Storage<unsigned long> vm_rss = 0;
+		Storage<unsigned long> rss_anon = 0;
+		Storage<unsigned long> rss_file = 0;
+		Storage<unsigned long> rss_shmem = 0;
+		Storage<unsigned long> vm_data = 0;
+		Storage<unsigned long> vm_stk = 0;
+		Storage<unsigned long> vm_exe = 0;
+		Storage<unsigned long> vm_lib = 0;
+		Storage<unsigned long> vm_pte = 0;
+		Storage<unsigned long> vm_swap = 0;
+		Storage<unsigned long> voluntary_ctxt_switches = 0;
+		Storage<unsigned long> nonvoluntary_ctxt_switches = 0;
+
+		size_t decode(std::string_view data);
+		bool read(pid_t pid);
+		bool read(const char* path = "/proc/self/status");
+	};
+}
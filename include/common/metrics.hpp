@@ -0,0 +1,76 @@
+#pragma once
+
+#include <ostream>
+#include <vector>
+#include <string_view>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+// Named counters and gauges for library level metrics. Counters are
+// incremented in a cell of the calling thread; cells of a thread are kept
+// in their own cache lines, so counting takes no locks, does no atomic
+// read-modify-write and never contends with other threads. Cells of an
+// exited thread are taken over by the next new thread, so their number is
+// bounded by threads alive at once and counts of exited threads stay.
+// Reading sums all cells. Gauges hold one value that is set or adjusted
+// from any thread.
+//
+// Objects should have static storage duration, they register themselves
+// on construction and are never removed. dump() writes all of them in
+// Prometheus text exposition format.
+
+namespace common {
+
+	namespace metrics {
+
+		enum class kind { counter, gauge };
+
+		struct sample {
+			const char* name;
+			const char* help;
+			metrics::kind kind;
+			int64_t value;
+		};
+
+		class counter {
+
+			private:
+				size_t id;
+
+			public:
+				counter(const char* name, const char* help);
+				counter(const counter&) = delete;
+
+				void add(uint64_t n = 1);
+				void operator ++() { this -> add(1); }
+				void operator ++(int) { this -> add(1); }
+				void operator +=(uint64_t n) { this -> add(n); }
+
+				// sum over all threads
+				uint64_t value() const;
+		};
+
+		class alignas(64) gauge {
+
+			private:
+				std::atomic<int64_t> v{0};
+
+			public:
+				gauge(const char* name, const char* help);
+				gauge(const gauge&) = delete;
+
+				void set(int64_t n) { this -> v.store(n, std::memory_order_relaxed); }
+				void add(int64_t n) { this -> v.fetch_add(n, std::memory_order_relaxed); }
+				int64_t value() const { return this -> v.load(std::memory_order_relaxed); }
+		};
+
+		// all counters and gauges in registration order
+		std::vector<sample> report();
+
+		// value of metric with name, 0 when there is none
+		int64_t read(std::string_view name);
+
+		void dump(std::ostream& os);
+	}
+}
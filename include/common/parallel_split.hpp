@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstddef>
+
+#include "common.hpp"
+#include "common/thread_pool.hpp"
+
+namespace common {
+
+	// Parallel counterparts of common::lines and common::split for large
+	// buffers. Buffer is cut into chunks of about chunk_size bytes, each cut
+	// moved forward to just after the next delimiter, chunks are tokenized
+	// on the pool and per chunk results are stitched together in order.
+	// Results are identical to the sequential functions: text after the
+	// last delimiter is not a token, and with trimchars, those characters
+	// are removed before tokenizing.
+
+	const size_t parallel_chunk_size = 1 << 20;
+
+	// views into data, same tokens as lines(data, delim, "") or, with
+	// skip_empty, split(data, delim, "")
+	std::vector<std::string_view> parallel_tokenize(std::string_view data, const common::char_type& delim = '\n',
+		bool skip_empty = false, common::thread_pool& pool = common::thread_pool::shared(),
+		size_t chunk_size = common::parallel_chunk_size);
+
+	std::vector<std::string> parallel_lines(const std::string& str, const common::char_type& delim = '\n',
+		const std::string& trimchars = "\r", common::thread_pool& pool = common::thread_pool::shared(),
+		size_t chunk_size = common::parallel_chunk_size);
+	// delimiters longer than one character are tokenized sequentially
+	std::vector<std::string> parallel_lines(const std::string& str, const std::string& delim,
+		const std::string& trimchars = "\r", common::thread_pool& pool = common::thread_pool::shared(),
+		size_t chunk_size = common::parallel_chunk_size);
+
+	std::vector<std::string> parallel_split(const std::string& str, const common::char_type& delim = '\n',
+		const std::string& trimchars = "\r", common::thread_pool& pool = common::thread_pool::shared(),
+		size_t chunk_size = common::parallel_chunk_size);
+	std::vector<std::string> parallel_split(const std::string& str, const std::string& delim,
+		const std::string& trimchars = "\r", common::thread_pool& pool = common::thread_pool::shared(),
+		size_t chunk_size = common::parallel_chunk_size);
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <sys/types.h>
+
+namespace common {
+
+	// Samples every process of /proc. Directory is enumerated with
+	// getdents64, /proc/[pid]/stat of up to max_open processes, at most a
+	// quarter of descriptor limit, is kept open between samples and read
+	// with pread into a reused buffer, so a sample of an unchanged process
+	// table costs one pread per process; remaining processes are opened and
+	// closed per sample. A process is dropped only once it is gone; when its
+	// stat cannot be read for other reasons, such as lack of descriptors,
+	// previous sample of it is repeated, with cpu_delta 0.
+	class proc_table {
+
+		public:
+
+			// structure of arrays, index i of every vector describes same process
+			struct snapshot {
+
+				std::vector<pid_t> pid;
+				std::vector<pid_t> ppid;
+				std::vector<char> state;
+				std::vector<uint64_t> utime; // clock ticks
+				std::vector<uint64_t> stime; // clock ticks
+				std::vector<uint64_t> rss; // bytes
+				std::vector<uint32_t> threads;
+				std::vector<uint64_t> starttime; // clock ticks after boot
+				// utime + stime ticks since previous sample, 0 for new processes
+				std::vector<uint64_t> cpu_delta;
+
+				std::chrono::steady_clock::time_point time;
+				std::chrono::nanoseconds interval{0}; // since previous sample
+
+				size_t size() const { return this -> pid.size(); }
+				std::string_view name(size_t i) const;
+
+				// cpu usage during interval, 100.0 is one full cpu
+				double cpu_percent(size_t i) const;
+
+				void clear();
+				void reserve(size_t n);
+
+			private:
+				friend class proc_table;
+
+				std::string names;
+				std::vector<uint32_t> name_offset;
+				std::vector<uint32_t> name_length;
+				long ticks_per_second = 100;
+		};
+
+			proc_table(const std::string& proc = "/proc", size_t max_open = 256);
+			proc_table(const proc_table&) = delete;
+			proc_table& operator =(const proc_table&) = delete;
+			~proc_table();
+
+			// re-reads process table, returned reference stays valid until
+			// next call to sample()
+			const snapshot& sample();
+			const snapshot& current() const { return this -> snap; }
+
+			// descriptors kept open between samples
+			size_t open_files() const;
+
+		private:
+
+			struct entry {
+				int fd = -1;
+				uint64_t starttime = 0;
+				uint64_t ticks = 0;
+				uint32_t generation = 0;
+				uint32_t row = 0; // index in snap, or in previous after swap
+			};
+
+			int dir_fd = -1;
+			size_t fd_budget;
+			size_t persistent = 0;
+			uint32_t generation = 0;
+			long page_size;
+			snapshot snap;
+			snapshot previous;
+			std::unordered_map<pid_t, entry> entries;
+			std::vector<char> dents;
+			std::vector<char> buf;
+
+			void close_entry(entry& e);
+			ssize_t read_stat(pid_t pid, entry& e);
+			bool parse_stat(pid_t pid, size_t len, entry& e, bool is_new);
+			void repeat_previous(pid_t pid, entry& e);
+	};
+}
@@ -0,0 +1,183 @@
+#pragma once
+
+#include <string>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+#include <stdexcept>
+#include <type_traits>
+
+namespace common {
+
+	namespace snapshot {
+
+		// binary snapshot of tsl::ordered_map / common::lowercase_map. Layout is
+		// a header followed by the map's own serialization (values in order, then
+		// bucket array) in native byte order. When the loading process hashes
+		// keys identically, buckets are restored as-is and nothing is re-hashed.
+
+		static const uint64_t magic = 0x50414e534e4d4d43; // "CMMNSNAP"
+		static const uint32_t version = 1;
+
+		struct header {
+			uint64_t magic;
+			uint32_t version;
+			uint32_t size_width;
+			uint64_t hash_probe;
+			uint64_t payload_size;
+		};
+
+		// hashes of fixed keys with Map's hasher, header records them so that
+		// load() trusts stored buckets only when they were placed by the same
+		// hash function. Key type must be arithmetic or constructible from a
+		// string, for others probe is 0 and buckets are always rebuilt.
+		template<class Map>
+		uint64_t hash_probe();
+
+		class writer {
+
+			private:
+				std::string buf;
+
+				void write(const char* p, size_t n) { this -> buf.append(p, n); }
+
+			public:
+
+				template<typename V>
+				std::enable_if_t<std::is_arithmetic_v<V>> operator ()(const V& v) {
+					this -> write(reinterpret_cast<const char*>(&v), sizeof(V));
+				}
+
+				void operator ()(const std::string& s) {
+					uint64_t n = s.size();
+					this -> operator ()(n);
+					this -> write(s.data(), s.size());
+				}
+
+				template<typename A, typename B>
+				void operator ()(const std::pair<A, B>& p) {
+					this -> operator ()(p.first);
+					this -> operator ()(p.second);
+				}
+
+				const std::string& data() const { return this -> buf; }
+		};
+
+		class reader {
+
+			private:
+				const char* pos;
+				const char* end;
+
+				const char* take(size_t n);
+
+				template<typename V>
+				std::enable_if_t<std::is_arithmetic_v<V>> read(V& v) {
+					std::memcpy(&v, this -> take(sizeof(V)), sizeof(V));
+				}
+
+				void read(std::string& s) {
+					uint64_t n;
+					this -> read(n);
+					s.assign(this -> take(n), n);
+				}
+
+				template<typename A, typename B>
+				void read(std::pair<A, B>& p) {
+					this -> read(p.first);
+					this -> read(p.second);
+				}
+
+			public:
+
+				reader(const char* data, size_t size) : pos(data), end(data + size) {}
+
+				template<typename V>
+				V operator ()() {
+					V v;
+					this -> read(v);
+					return v;
+				}
+
+				bool eof() const { return this -> pos == this -> end; }
+		};
+
+		// read-only, private mapping of a snapshot file
+		class mapped_file {
+
+			private:
+				void* addr = nullptr;
+				size_t length = 0;
+
+			public:
+
+				mapped_file(const std::string& filename);
+				mapped_file(const mapped_file&) = delete;
+				mapped_file& operator =(const mapped_file&) = delete;
+				~mapped_file();
+
+				const char* data() const { return static_cast<const char*>(this -> addr); }
+				size_t size() const { return this -> length; }
+		};
+
+		void write_file(const std::string& filename, const std::string& payload, uint64_t hash_probe);
+
+		template<class Map>
+		void save(const std::string& filename, const Map& map);
+
+		template<class Map>
+		Map load(const std::string& filename);
+	}
+}
+
+template<class Map>
+uint64_t common::snapshot::hash_probe() {
+
+	using key_type = typename Map::key_type;
+	typename Map::hasher h;
+	uint64_t a, b;
+
+	if constexpr ( std::is_constructible_v<key_type, const char*> ) {
+		a = h(key_type("common::snapshot hash probe"));
+		b = h(key_type("0123456789abcdefghijklmnopqrstuvwxyz"));
+	} else if constexpr ( std::is_arithmetic_v<key_type> ) {
+		a = h(key_type(42));
+		b = h(key_type(97));
+	} else return 0;
+
+	uint64_t probe = a * 0x9e3779b97f4a7c15ULL ^ b;
+	return probe != 0 ? probe : 1;
+}
+
+template<class Map>
+void common::snapshot::save(const std::string& filename, const Map& map) {
+
+	common::snapshot::writer w;
+	map.serialize(w);
+	common::snapshot::write_file(filename, w.data(), common::snapshot::hash_probe<Map>());
+}
+
+template<class Map>
+Map common::snapshot::load(const std::string& filename) {
+
+	common::snapshot::mapped_file f(filename);
+	common::snapshot::header h;
+
+	if ( f.size() < sizeof(h))
+		throw std::runtime_error("invalid snapshot " + filename + ", file is truncated");
+
+	std::memcpy(&h, f.data(), sizeof(h));
+
+	if ( h.magic != common::snapshot::magic || h.version != common::snapshot::version )
+		throw std::runtime_error("invalid snapshot " + filename + ", unknown format");
+
+	if ( h.payload_size != f.size() - sizeof(h))
+		throw std::runtime_error("invalid snapshot " + filename + ", size mismatch");
+
+	uint64_t probe = common::snapshot::hash_probe<Map>();
+	bool hash_compatible = probe != 0 && h.hash_probe == probe &&
+		h.size_width == sizeof(size_t);
+
+	common::snapshot::reader r(f.data() + sizeof(h), h.payload_size);
+	return Map::deserialize(r, hash_compatible);
+}
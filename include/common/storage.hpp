@@ -3,6 +3,8 @@
 #include <ostream>
 #include <istream>
 #include <type_traits>
+#include <vector>
+#include <cstddef>
 
 namespace common {
 
@@ -78,6 +80,13 @@ class Storage {
 		T mb() const;
 		T gb() const;
 
+		// batch conversion of count values from in to out, results are identical
+		// to calling mb() or gb() for each value.
+		static void mb(const Storage<T>* in, T* out, size_t count);
+		static void gb(const Storage<T>* in, T* out, size_t count);
+		static std::vector<T> mb(const std::vector<Storage<T>>& in);
+		static std::vector<T> gb(const std::vector<Storage<T>>& in);
+
 };
 
 } // end of namespace
@@ -110,6 +119,69 @@ T common::Storage<T>::gb() const {
 	else return common::Storage<T>::size_division(_mb);
 }
 
+// For unsigned integers size_division(v) is exactly v / 1024 as long as ten
+// times the quotient fits in double's mantissa, which holds for all values
+// below 2^58. Batches within that range are converted with plain shifts that
+// the compiler vectorises, others go through size_division one by one.
+
+template<typename T>
+void common::Storage<T>::mb(const common::Storage<T>* in, T* out, size_t count) {
+
+	if constexpr ( std::is_integral<T>::value && std::is_unsigned<T>::value ) {
+
+		T high = 0;
+		for ( size_t i = 0; i < count; i++ )
+			high |= in[i].value;
+
+		if ( (unsigned long long)high < ( 1ULL << 58 )) {
+
+			for ( size_t i = 0; i < count; i++ )
+				out[i] = in[i].value >> 10;
+			return;
+		}
+	}
+
+	for ( size_t i = 0; i < count; i++ )
+		out[i] = common::Storage<T>::size_division(in[i].value);
+}
+
+template<typename T>
+void common::Storage<T>::gb(const common::Storage<T>* in, T* out, size_t count) {
+
+	if constexpr ( std::is_integral<T>::value && std::is_unsigned<T>::value ) {
+
+		T high = 0;
+		for ( size_t i = 0; i < count; i++ )
+			high |= in[i].value;
+
+		if ( (unsigned long long)high < ( 1ULL << 58 )) {
+
+			for ( size_t i = 0; i < count; i++ )
+				out[i] = in[i].value >> 20;
+			return;
+		}
+	}
+
+	for ( size_t i = 0; i < count; i++ )
+		out[i] = common::Storage<T>::size_division(common::Storage<T>::size_division(in[i].value));
+}
+
+template<typename T>
+std::vector<T> common::Storage<T>::mb(const std::vector<common::Storage<T>>& in) {
+
+	std::vector<T> out(in.size());
+	common::Storage<T>::mb(in.data(), out.data(), in.size());
+	return out;
+}
+
+template<typename T>
+std::vector<T> common::Storage<T>::gb(const std::vector<common::Storage<T>>& in) {
+
+	std::vector<T> out(in.size());
+	common::Storage<T>::gb(in.data(), out.data(), in.size());
+	return out;
+}
+
 template<typename T>
 std::ostream& operator <<(std::ostream& os, const common::Storage<T>& s) {
 
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <iterator>
+#include <type_traits>
+#include <memory_resource>
+#include <cstddef>
+
+namespace common {
+
+	// Work-stealing thread pool. parallel_for splits an index range into
+	// tasks; a worker splits the task it takes in halves down to grain size,
+	// runs the nearest half itself and leaves the rest on its own deque,
+	// where idle workers steal from the opposite end. Calling thread helps
+	// until all of its work is done, so calls may nest, also from inside a
+	// body. First exception thrown by a body is rethrown to caller, items
+	// not yet started are skipped after it.
+	//
+	// Ranges can be anything with begin() and end(): containers,
+	// common::enumerate(v), its range(), chunks() and split() results, or
+	// common::chunk(v, n); body gets what dereferencing the iterator gives.
+	// Ranges without random access iterators are walked once up front.
+	class thread_pool {
+
+		public:
+
+			// 0 threads means one per hardware thread, minus the caller
+			thread_pool(size_t threads = 0);
+			thread_pool(const thread_pool&) = delete;
+			thread_pool& operator =(const thread_pool&) = delete;
+			~thread_pool();
+
+			size_t size() const { return this -> workers.size(); }
+
+			// pool shared by whole process, created on first use
+			static thread_pool& shared();
+
+			// monotonic scratch memory of calling thread. On pool workers it
+			// is released when the worker's outermost task returns, so
+			// allocations made by a body stay valid until that body returns,
+			// also while it waits for a nested parallel_for. Pool never
+			// releases scratch of other threads, see release_scratch().
+			static std::pmr::memory_resource* scratch();
+
+			// releases scratch of calling thread, nothing allocated from it
+			// may be in use
+			static void release_scratch();
+
+			// f(i) for i in [first, last)
+			template <typename F>
+			void parallel_for(size_t first, size_t last, F&& f, size_t grain = 0) {
+
+				auto body = [first, &f](size_t b, size_t e) {
+					for ( size_t i = first + b; i < first + e; i++ )
+						f(i);
+				};
+
+				this -> run(last > first ? last - first : 0, grain, &thread_pool::invoke<decltype(body)>, &body);
+			}
+
+			// f(element) for every element of range
+			template <typename Range, typename F>
+			void parallel_for(Range&& r, F&& f, size_t grain = 0) {
+
+				this -> for_each_iterator(r, [&f](auto it) { f(*it); }, grain);
+			}
+
+			// f(i) for i in [first, last), results in order
+			template <typename F>
+			auto parallel_transform(size_t first, size_t last, F&& f, size_t grain = 0) {
+
+				std::vector<std::decay_t<decltype(f(first))>> out(last > first ? last - first : 0);
+				this -> parallel_for(first, last, [&](size_t i) { out[i - first] = f(i); }, grain);
+				return out;
+			}
+
+			// f(element) for every element of range, results in order
+			template <typename Range, typename F>
+			auto parallel_transform(Range&& r, F&& f, size_t grain = 0) {
+
+				std::vector<std::decay_t<decltype(f(*std::begin(r)))>> out;
+				auto first = std::begin(r);
+
+				if constexpr ( thread_pool::random_access<decltype(first)>) {
+
+					out.resize(std::distance(first, std::end(r)));
+					this -> parallel_for((size_t)0, out.size(), [&](size_t i) { out[i] = f(first[i]); }, grain);
+
+				} else {
+
+					std::vector<decltype(first)> its;
+					for ( auto it = first; it != std::end(r); ++it )
+						its.push_back(it);
+
+					out.resize(its.size());
+					this -> parallel_for((size_t)0, its.size(), [&](size_t i) { out[i] = f(*its[i]); }, grain);
+				}
+
+				return out;
+			}
+
+		private:
+
+			struct job;
+
+			struct task {
+				job* owner;
+				size_t begin;
+				size_t end;
+			};
+
+			struct alignas(64) queue {
+				std::mutex lock;
+				std::deque<task> tasks;
+			};
+
+			std::vector<std::thread> workers;
+			std::vector<std::unique_ptr<queue>> queues; // one per worker, last one for outside callers
+			std::mutex sleep_lock;
+			std::condition_variable wake;
+			std::atomic<size_t> queued{0};
+			bool stop = false;
+
+			// views' iterators have no traits, they are walked like forward ones
+			template <typename It, typename = void>
+			struct is_random_access : std::false_type {};
+
+			template <typename It>
+			struct is_random_access<It, std::void_t<typename std::iterator_traits<It>::iterator_category>> :
+				std::is_base_of<std::random_access_iterator_tag, typename std::iterator_traits<It>::iterator_category> {};
+
+			template <typename It>
+			static constexpr bool random_access = is_random_access<It>::value;
+
+			template <typename B>
+			static void invoke(void* body, size_t begin, size_t end) {
+				(*static_cast<B*>(body))(begin, end);
+			}
+
+			template <typename Range, typename G>
+			void for_each_iterator(Range& r, G&& g, size_t grain) {
+
+				auto first = std::begin(r);
+
+				if constexpr ( thread_pool::random_access<decltype(first)>) {
+
+					auto body = [first, &g](size_t b, size_t e) {
+						auto it = first + b;
+						for ( size_t i = b; i < e; i++, ++it )
+							g(it);
+					};
+
+					this -> run(std::distance(first, std::end(r)), grain, &thread_pool::invoke<decltype(body)>, &body);
+
+				} else {
+
+					std::vector<decltype(first)> its;
+					for ( auto it = first; it != std::end(r); ++it )
+						its.push_back(it);
+
+					auto body = [&its, &g](size_t b, size_t e) {
+						for ( size_t i = b; i < e; i++ )
+							g(its[i]);
+					};
+
+					this -> run(its.size(), grain, &thread_pool::invoke<decltype(body)>, &body);
+				}
+			}
+
+			void run(size_t count, size_t grain, void (*fn)(void*, size_t, size_t), void* body);
+			void push(size_t slot, const task& t);
+			bool pop(size_t slot, task& t);
+			bool steal(size_t slot, task& t);
+			void execute(size_t slot, task t);
+			void worker(size_t slot);
+			size_t current_slot() const;
+	};
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <ostream>
+#include <cstddef>
+
+// Event tracing, enabled by building with -DCOMMON_TRACE (make COMMON_TRACE=1).
+// COMMON_TRACE_SCOPE("name") records a begin event when reached and an end
+// event when the enclosing scope exits. Events go to a ring buffer of the
+// calling thread, oldest events are overwritten once it is full. Timestamps
+// come from common::clock::tsc. Buffer of an exited thread is taken over by
+// the next new thread, its events are kept until overwritten. write_json()
+// exports events of all threads in Chrome trace event format; load the
+// output in chrome://tracing or https://ui.perfetto.dev.
+//
+// Without the define, COMMON_TRACE_SCOPE() expands to nothing and traces
+// are always empty. Library's own file reading and parsing functions are
+// instrumented.
+
+namespace common {
+
+	namespace trace {
+
+		// events per thread, applies to buffers created after the call;
+		// buffers taken over from exited threads keep their capacity
+		void set_capacity(size_t events);
+
+		// recording can be paused at runtime, it is on by default
+		void enable(bool on);
+		bool enabled();
+
+		// events currently held in all buffers
+		size_t size();
+
+		void write_json(std::ostream& os);
+		void clear();
+
+#ifdef COMMON_TRACE
+		void begin(const char* name);
+		void end(const char* name);
+
+		class scope {
+
+			private:
+				const char* name;
+				bool active;
+
+			public:
+				scope(const char* name) : name(name), active(trace::enabled()) {
+					if ( this -> active )
+						trace::begin(name);
+				}
+
+				scope(const scope&) = delete;
+
+				~scope() {
+					if ( this -> active )
+						trace::end(this -> name);
+				}
+		};
+#endif
+	}
+}
+
+#ifdef COMMON_TRACE
+#define COMMON_TRACE_SCOPE(name) \
+	common::trace::scope _common_trace_scope(name)
+#else
+#define COMMON_TRACE_SCOPE(name)
+#endif
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <ostream>
+#include <type_traits>
+
+#include "common/storage.hpp"
+
+namespace common {
+
+	namespace unit {
+
+		struct bytes { static constexpr unsigned shift = 0; static constexpr const char* suffix = "b"; };
+		struct KiB { static constexpr unsigned shift = 10; static constexpr const char* suffix = "KiB"; };
+		struct MiB { static constexpr unsigned shift = 20; static constexpr const char* suffix = "MiB"; };
+		struct GiB { static constexpr unsigned shift = 30; static constexpr const char* suffix = "GiB"; };
+
+		// the finer of two units, mixed-unit arithmetic results are in it
+		template<typename U1, typename U2>
+		using finer = std::conditional_t<( U1::shift <= U2::shift ), U1, U2>;
+	}
+
+// Storage value tagged with its unit at compile time. Conversions between
+// units are resolved to a single shift (or multiplication/division by a
+// power of two for floating point types); converting to a coarser unit
+// truncates. Arithmetic between different units converts the coarser operand
+// to the finer unit, which is exact.
+template<typename T, typename Unit>
+class unit_storage {
+
+	static_assert(std::is_arithmetic<T>::value, "Not an arithmetic type, Storage type must be numeric");
+
+	private:
+
+		T value;
+
+		template<int Shift>
+		static constexpr T shifted(T v) {
+			if constexpr ( Shift == 0 )
+				return v;
+			else if constexpr ( std::is_floating_point<T>::value )
+				return Shift > 0 ? v / (T)(1ULL << Shift) : v * (T)(1ULL << -Shift);
+			else if constexpr ( Shift > 0 )
+				return v >> Shift;
+			else return v << -Shift;
+		}
+
+	public:
+
+		using value_type = T;
+		using unit_type = Unit;
+
+		constexpr unit_storage() : value(0) {}
+		constexpr explicit unit_storage(T v) : value(v) {}
+
+		// converting between units must be explicit
+		template<typename U>
+		constexpr explicit unit_storage(const unit_storage<T, U>& o) : value(o.template as<Unit>()) {}
+
+		template<typename U>
+		constexpr T as() const {
+			return unit_storage::shifted<(int)U::shift - (int)Unit::shift>(this -> value);
+		}
+
+		template<typename U>
+		constexpr unit_storage<T, U> to() const {
+			return unit_storage<T, U>(this -> template as<U>());
+		}
+
+		constexpr T raw() const { return this -> value; }
+		constexpr T bytes() const { return this -> template as<unit::bytes>(); }
+		constexpr T kib() const { return this -> template as<unit::KiB>(); }
+		constexpr T mib() const { return this -> template as<unit::MiB>(); }
+		constexpr T gib() const { return this -> template as<unit::GiB>(); }
+
+		// Storage counts KiB, value is converted (and truncated) to it
+		Storage<T> storage() const { return Storage<T>(this -> kib()); }
+
+		constexpr unit_storage operator *(const T& v) const { return unit_storage(this -> value * v); }
+		constexpr unit_storage operator /(const T& v) const { return unit_storage(this -> value / v); }
+		constexpr unit_storage& operator *=(const T& v) { this -> value *= v; return *this; }
+		constexpr unit_storage& operator /=(const T& v) { this -> value /= v; return *this; }
+
+		template<typename U>
+		constexpr unit_storage<T, unit::finer<Unit, U>> operator +(const unit_storage<T, U>& o) const {
+			using R = unit::finer<Unit, U>;
+			return unit_storage<T, R>(this -> template as<R>() + o.template as<R>());
+		}
+
+		template<typename U>
+		constexpr unit_storage<T, unit::finer<Unit, U>> operator -(const unit_storage<T, U>& o) const {
+			using R = unit::finer<Unit, U>;
+			return unit_storage<T, R>(this -> template as<R>() - o.template as<R>());
+		}
+
+		// compound assignment keeps the unit of left side, a finer right side is truncated
+		template<typename U>
+		constexpr unit_storage& operator +=(const unit_storage<T, U>& o) { this -> value += o.template as<Unit>(); return *this; }
+
+		template<typename U>
+		constexpr unit_storage& operator -=(const unit_storage<T, U>& o) { this -> value -= o.template as<Unit>(); return *this; }
+
+		template<typename U>
+		constexpr bool operator ==(const unit_storage<T, U>& o) const {
+			using R = unit::finer<Unit, U>;
+			return this -> template as<R>() == o.template as<R>();
+		}
+
+		template<typename U>
+		constexpr bool operator !=(const unit_storage<T, U>& o) const { return !( *this == o ); }
+
+		template<typename U>
+		constexpr bool operator <(const unit_storage<T, U>& o) const {
+			using R = unit::finer<Unit, U>;
+			return this -> template as<R>() < o.template as<R>();
+		}
+
+		template<typename U>
+		constexpr bool operator >(const unit_storage<T, U>& o) const { return o < *this; }
+
+		template<typename U>
+		constexpr bool operator <=(const unit_storage<T, U>& o) const { return !( o < *this ); }
+
+		template<typename U>
+		constexpr bool operator >=(const unit_storage<T, U>& o) const { return !( *this < o ); }
+};
+
+template<typename T>
+using bytes_storage = unit_storage<T, unit::bytes>;
+
+template<typename T>
+using kib_storage = unit_storage<T, unit::KiB>;
+
+template<typename T>
+using mib_storage = unit_storage<T, unit::MiB>;
+
+template<typename T>
+using gib_storage = unit_storage<T, unit::GiB>;
+
+} // end of namespace
+
+template<typename T, typename Unit>
+std::ostream& operator <<(std::ostream& os, const common::unit_storage<T, Unit>& s) {
+
+	os << s.raw() << Unit::suffix;
+	return os;
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include <type_traits>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <tuple>
+#include <algorithm>
+
+// lightweight, allocation free views for range-for loops, companions of
+// common::enumerate. Iterators keep a single position to compare against,
+// so loop bodies over contiguous containers stay vectorisable.
+
+namespace common {
+
+	template <typename container_type>
+	using view_iterator_t = std::conditional_t<std::is_const_v<container_type>, typename container_type::const_iterator, typename container_type::iterator>;
+
+	// sub-range of a container, element type of chunk views
+	template <typename iterator_type>
+	struct view_range {
+
+		iterator_type first;
+		iterator_type last;
+
+		constexpr iterator_type begin() const { return first; }
+		constexpr iterator_type end() const { return last; }
+		constexpr size_t size() const { return std::distance(first, last); }
+		constexpr bool empty() const { return first == last; }
+		constexpr decltype(auto) operator[](size_t n) const { return first[n]; }
+	};
+
+	// zip: walks several containers side by side, up to length of the shortest one
+	template <typename... container_types>
+	struct zip_wrapper {
+
+		struct zip_iter {
+
+			std::tuple<view_iterator_t<container_types>...> value;
+
+			constexpr bool operator!=(const zip_iter& other) const {
+				return std::get<0>(value) != std::get<0>(other.value);
+			}
+
+			constexpr bool operator==(const zip_iter& other) const {
+				return std::get<0>(value) == std::get<0>(other.value);
+			}
+
+			constexpr zip_iter& operator++() {
+				std::apply([](auto&... it) { ( ++it, ... ); }, value);
+				return *this;
+			}
+
+			constexpr auto operator*() const {
+				return std::apply([](const auto&... it) {
+					return std::tuple<decltype(*it)...>(*it...);
+				}, value);
+			}
+		};
+
+		constexpr zip_wrapper(container_types&... c): containers(c...) {}
+
+		constexpr size_t size() const {
+			return std::apply([](const auto&... c) { return std::min({ (size_t)std::size(c)... }); }, containers);
+		}
+
+		constexpr zip_iter begin() {
+			return { std::apply([](auto&... c) { return std::make_tuple(std::begin(c)...); }, containers) };
+		}
+
+		constexpr zip_iter end() {
+			size_t n = size();
+			return { std::apply([n](auto&... c) { return std::make_tuple(std::next(std::begin(c), n)...); }, containers) };
+		}
+
+		std::tuple<container_types&...> containers;
+	};
+
+	// chunk: consecutive sub-ranges of n elements, last one may be shorter
+	template <typename container_type>
+	struct chunk_wrapper {
+
+		using iterator_type = view_iterator_t<container_type>;
+
+		struct chunk_iter {
+
+			iterator_type value;
+			iterator_type last;
+			size_t n;
+
+			constexpr iterator_type next() const {
+				return (size_t)std::distance(value, last) > n ? std::next(value, n) : last;
+			}
+
+			constexpr bool operator!=(const chunk_iter& other) const {
+				return value != other.value;
+			}
+
+			constexpr bool operator==(const chunk_iter& other) const {
+				return value == other.value;
+			}
+
+			constexpr chunk_iter& operator++() {
+				value = next();
+				return *this;
+			}
+
+			constexpr view_range<iterator_type> operator*() const {
+				return view_range<iterator_type>{value, next()};
+			}
+		};
+
+		constexpr chunk_wrapper(container_type& c, size_t n): container(c), n(n == 0 ? 1 : n) {}
+
+		constexpr size_t size() const {
+			return ( std::size(container) + n - 1 ) / n;
+		}
+
+		constexpr chunk_iter begin() {
+			return {std::begin(container), std::end(container), n};
+		}
+
+		constexpr chunk_iter end() {
+			return {std::end(container), std::end(container), n};
+		}
+
+		container_type& container;
+		size_t n;
+	};
+
+	// stride: every n'th element, starting from first
+	template <typename container_type>
+	struct stride_wrapper {
+
+		using iterator_type = view_iterator_t<container_type>;
+
+		struct stride_iter {
+
+			iterator_type value;
+			size_t remaining;
+			size_t n;
+
+			constexpr bool operator!=(const stride_iter& other) const {
+				return remaining != other.remaining;
+			}
+
+			constexpr bool operator==(const stride_iter& other) const {
+				return remaining == other.remaining;
+			}
+
+			constexpr stride_iter& operator++() {
+				if ( --remaining > 0 )
+					std::advance(value, n);
+				return *this;
+			}
+
+			constexpr decltype(auto) operator*() const {
+				return *value;
+			}
+		};
+
+		constexpr stride_wrapper(container_type& c, size_t n): container(c), n(n == 0 ? 1 : n) {}
+
+		constexpr size_t size() const {
+			return ( std::size(container) + n - 1 ) / n;
+		}
+
+		constexpr stride_iter begin() {
+			return {std::begin(container), size(), n};
+		}
+
+		constexpr stride_iter end() {
+			return {std::end(container), 0, n};
+		}
+
+		container_type& container;
+		size_t n;
+	};
+
+	template <typename... container_types>
+	constexpr auto zip(container_types&... c) {
+		return zip_wrapper<container_types...>(c...);
+	}
+
+	template <typename container_type>
+	constexpr auto chunk(container_type& c, size_t n) {
+		return chunk_wrapper<container_type>(c, n);
+	}
+
+	template <typename container_type>
+	constexpr auto stride(container_type& c, size_t n) {
+		return stride_wrapper<container_type>(c, n);
+	}
+}
@@ -2,29 +2,45 @@
 
 #include <utility>
 #include <string>
+#include <vector>
+#include <cctype>
+#include <cassert>
+#include <iterator>
+#include <type_traits>
+#include <string_view>
 
 #include "tsl/ordered_map.h"
 #include "common.hpp"
 
 namespace common {
 
-	template <class T>
+	// ValueTypeContainer holds the entries in insertion order. The default
+	// std::deque keeps references stable on growth and makes erasing at the
+	// front cheap, std::vector keeps entries contiguous, see lowercase_vector_map.
+	template <class T, class ValueTypeContainer>
 	class lowercase_map {
 
 	public:
+		using key_type = std::string;
 		using mapped_type = T;
 		using value_type = typename std::pair<std::string, T>;
-		using map_type = typename tsl::ordered_map<std::string, T>;
+		using values_container_type = ValueTypeContainer;
+		using map_type = typename tsl::ordered_map<std::string, T, std::hash<std::string>, std::equal_to<std::string>,
+			typename ValueTypeContainer::allocator_type, ValueTypeContainer>;
 		using size_type = typename map_type::size_type;
-		using Self = typename common::lowercase_map<T>;
+		using hasher = typename map_type::hasher;
+		using Self = typename common::lowercase_map<T, ValueTypeContainer>;
 
-		using iterator = typename tsl::ordered_map<std::string, T>::iterator;
-		using const_iterator = typename tsl::ordered_map<std::string, T>::const_iterator;
+		using iterator = typename map_type::iterator;
+		using const_iterator = typename map_type::const_iterator;
 
 
 	private:
 		map_type _m;
 
+		static std::string lowered(std::string&& key);
+		static bool is_lowered(const map_type& map);
+
 	public:
 
 		iterator begin();
@@ -42,20 +58,22 @@ namespace common {
                 T operator [](const std::string& key) const;
                 T operator [](std::string& key) const;
 
-		bool operator ==(const lowercase_map<T>& other);
-		bool operator !=(const lowercase_map<T>& other);
-		bool operator <(const lowercase_map<T>&other);
-		bool operator <=(const lowercase_map<T>&other);
-		bool operator >(const lowercase_map<T>&other);
-		bool operator >=(const lowercase_map<T>&other);
+		bool operator ==(const Self& other);
+		bool operator !=(const Self& other);
+		bool operator <(const Self& other);
+		bool operator <=(const Self& other);
+		bool operator >(const Self& other);
+		bool operator >=(const Self& other);
 #if __cplusplus >= 202002L
-		bool operator <=>(const lowercase_map<T>&other);
+		bool operator <=>(const Self& other);
 #endif
 
 		Self& operator =(const std::initializer_list<value_type>& l);
 		Self& operator =(const Self& other);
 		Self& operator =(const map_type& map);
 		Self& operator =(const value_type& pair);
+		Self& operator =(Self&& other) noexcept;
+		Self& operator =(map_type&& map);
 
 		Self& operator *();
 		const Self& operator*() const;
@@ -67,6 +85,11 @@ namespace common {
 		lowercase_map(const Self& other);
 		lowercase_map(const map_type& map);
 		lowercase_map(const value_type& pair);
+		lowercase_map(Self&& other) noexcept;
+		lowercase_map(map_type&& map);
+
+		template <class InputIt>
+		lowercase_map(InputIt first, InputIt last);
 
 		T& at(const std::string& key);
 		const T at(const std::string& key) const;
@@ -77,13 +100,34 @@ namespace common {
 		size_type size() const;
 		size_type max_size() const;
 
+		void reserve(size_type count);
+		void rehash(size_type count);
+
 		void insert(const std::initializer_list<value_type>& l);
 		void insert(const Self& other);
 		void insert(const value_type& pair);
+		void insert(Self&& other);
+		void insert(value_type&& pair);
+
+		template <class InputIt>
+		void insert(InputIt first, InputIt last);
+		template <class InputIt>
+		void assign_unique(InputIt first, InputIt last);
+
+		template <class... Args>
+		std::pair<iterator, bool> emplace(const std::string& key, Args&&... args);
+		template <class... Args>
+		std::pair<iterator, bool> emplace(std::string&& key, Args&&... args);
+		template <class... Args>
+		std::pair<iterator, bool> try_emplace(const std::string& key, Args&&... args);
+		template <class... Args>
+		std::pair<iterator, bool> try_emplace(std::string&& key, Args&&... args);
 
 		void append(const std::initializer_list<value_type>& l);
 		void append(const Self& other);
 		void append(const value_type& pair);
+		void append(Self&& other);
+		void append(value_type&& pair);
 
 		const value_type& front() const;
 		const value_type& back() const;
@@ -93,120 +137,147 @@ namespace common {
 		bool emplace_at_position(const_iterator pos, value_type& value);
 		bool rename(const std::string& old_key, const std::string& new_key);
 		void pop_back();
+		void pop_front(size_type count = 1);
 
 		size_type erase(const std::string& key);
 		size_type erase(iterator pos);
 		size_type erase(const_iterator pos);
+		size_type unordered_erase(const std::string& key);
+		iterator unordered_erase(iterator pos);
+		iterator unordered_erase(const_iterator pos);
 		void clear();
 
+		template <class Serializer>
+		void serialize(Serializer& serializer) const;
+		template <class Deserializer>
+		static Self deserialize(Deserializer& deserializer, bool hash_compatible = false);
+
 	}; // end of class common::lowercase_map<T> introduction
 
-	template <class T>
-	typename lowercase_map<T>::iterator lowercase_map<T>::begin() {
+	template <class T, class C>
+	std::string lowercase_map<T, C>::lowered(std::string&& key) {
+
+		for ( auto& ch : key )
+			if ( std::isupper(ch))
+				ch ^= 32;
+		return std::move(key);
+	}
+
+	template <class T, class C>
+	bool lowercase_map<T, C>::is_lowered(const lowercase_map<T, C>::map_type& map) {
+
+		for ( auto& [key, value] : map )
+			if ( std::any_of(key.begin(), key.end(), [](const char& ch) { return std::isupper(ch); }))
+				return false;
+		return true;
+	}
+
+	template <class T, class C>
+	typename lowercase_map<T, C>::iterator lowercase_map<T, C>::begin() {
 		return this -> _m.begin();
 	}
 
-	template <class T>
-	typename lowercase_map<T>::iterator lowercase_map<T>::end() {
+	template <class T, class C>
+	typename lowercase_map<T, C>::iterator lowercase_map<T, C>::end() {
 		return this -> _m.end();
 	}
 
-	template <class T>
-	typename lowercase_map<T>::iterator lowercase_map<T>::find(const std::string& key) {
+	template <class T, class C>
+	typename lowercase_map<T, C>::iterator lowercase_map<T, C>::find(const std::string& key) {
 		auto it = this -> _m.find(key);
-		return lowercase_map<T>::iterator(it);
+		return lowercase_map<T, C>::iterator(it);
 	}
 
-	template <class T>
-	typename lowercase_map<T>::iterator lowercase_map<T>::mutable_iterator(lowercase_map<T>::const_iterator pos) {
-		return lowercase_map<T>::iterator(this -> _m.mutable_iterator(pos.c_it));
+	template <class T, class C>
+	typename lowercase_map<T, C>::iterator lowercase_map<T, C>::mutable_iterator(lowercase_map<T, C>::const_iterator pos) {
+		return lowercase_map<T, C>::iterator(this -> _m.mutable_iterator(pos));
 	}
 
-	template <class T>
-	typename lowercase_map<T>::const_iterator lowercase_map<T>::cbegin() const {
-		return lowercase_map<T>::const_iterator(this -> _m.cbegin());
+	template <class T, class C>
+	typename lowercase_map<T, C>::const_iterator lowercase_map<T, C>::cbegin() const {
+		return lowercase_map<T, C>::const_iterator(this -> _m.cbegin());
 	}
 
-	template <class T>
-	typename lowercase_map<T>::const_iterator lowercase_map<T>::cend() const {
-		return lowercase_map<T>::const_iterator(this -> _m.cend());
+	template <class T, class C>
+	typename lowercase_map<T, C>::const_iterator lowercase_map<T, C>::cend() const {
+		return lowercase_map<T, C>::const_iterator(this -> _m.cend());
 	}
 
-	template <class T>
-	typename lowercase_map<T>::const_iterator lowercase_map<T>::begin() const {
-		return lowercase_map<T>::const_iterator(this -> _m.cbegin());
+	template <class T, class C>
+	typename lowercase_map<T, C>::const_iterator lowercase_map<T, C>::begin() const {
+		return lowercase_map<T, C>::const_iterator(this -> _m.cbegin());
 	}
 
-	template <class T>
-	typename lowercase_map<T>::const_iterator lowercase_map<T>::end() const {
-		return lowercase_map<T>::const_iterator(this -> _m.cend());
+	template <class T, class C>
+	typename lowercase_map<T, C>::const_iterator lowercase_map<T, C>::end() const {
+		return lowercase_map<T, C>::const_iterator(this -> _m.cend());
 	}
 
-	template <class T>
-	typename lowercase_map<T>::const_iterator lowercase_map<T>::find(const std::string& key) const {
+	template <class T, class C>
+	typename lowercase_map<T, C>::const_iterator lowercase_map<T, C>::find(const std::string& key) const {
 		auto it = this -> _m.find(key);
-		return lowercase_map<T>::const_iterator(it);
+		return lowercase_map<T, C>::const_iterator(it);
 	}
 
-	template <class T>
-	T& lowercase_map<T>::operator [](const std::string& key) {
+	template <class T, class C>
+	T& lowercase_map<T, C>::operator [](const std::string& key) {
 		return this -> _m[common::to_lower(std::as_const(key))];
 	}
 
-	template <class T>
-	T& lowercase_map<T>::operator [](std::string& key) {
+	template <class T, class C>
+	T& lowercase_map<T, C>::operator [](std::string& key) {
 		return this -> _m[common::to_lower(std::as_const(key))];
 	}
 
-	template <class T>
-	T lowercase_map<T>::operator [](const std::string& key) const {
+	template <class T, class C>
+	T lowercase_map<T, C>::operator [](const std::string& key) const {
 		return this -> _m[common::to_lower(std::as_const(key))];
 	}
 
-	template <class T>
-	T lowercase_map<T>::operator [](std::string& key) const {
+	template <class T, class C>
+	T lowercase_map<T, C>::operator [](std::string& key) const {
 		return this -> _m[common::to_lower(std::as_const(key))];
 	}
 
-	template <class T>
-	bool lowercase_map<T>::operator ==(const lowercase_map<T>& other) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::operator ==(const lowercase_map<T, C>& other) {
 		return this -> _m == other._m;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::operator !=(const lowercase_map<T>& other) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::operator !=(const lowercase_map<T, C>& other) {
 		return this -> _m != other._m;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::operator <(const lowercase_map<T>&other) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::operator <(const lowercase_map<T, C>&other) {
 		return this -> _m < other._m;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::operator <=(const lowercase_map<T>&other) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::operator <=(const lowercase_map<T, C>&other) {
 		return this -> _m <= other._m;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::operator >(const lowercase_map<T>&other) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::operator >(const lowercase_map<T, C>&other) {
 		return this -> _m > other._m;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::operator >=(const lowercase_map<T>&other) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::operator >=(const lowercase_map<T, C>&other) {
 		return this -> _m >= other._m;
 	}
 
 #if __cplusplus >= 202002L
-	template <class T>
-	bool lowercase_map<T>::operator <=>(const lowercase_map<T>&other) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::operator <=>(const lowercase_map<T, C>&other) {
 		return this -> _m <=> other._m;
 	}
 #endif
 
-	template <class T>
-	lowercase_map<T>& lowercase_map<T>::operator =(const std::initializer_list<std::pair<std::string, T>>& l) {
+	template <class T, class C>
+	lowercase_map<T, C>& lowercase_map<T, C>::operator =(const std::initializer_list<std::pair<std::string, T>>& l) {
 
 		this -> _m.clear();
 		for ( auto& [key, value] : l )
@@ -214,17 +285,17 @@ namespace common {
 		return *this;
 	}
 
-	template <class T>
-	lowercase_map<T>& lowercase_map<T>::operator =(const lowercase_map<T>& other) {
+	template <class T, class C>
+	lowercase_map<T, C>& lowercase_map<T, C>::operator =(const lowercase_map<T, C>& other) {
 
-		this -> _m.clear();
-		for ( auto& [key, value] : other )
-			this -> _m[common::to_lower(std::as_const(key))] = value;
+		// keys of other lowercase_map are already lowercase
+		if ( this != &other )
+			this -> _m = other._m;
 		return *this;
 	}
 
-	template <class T>
-	lowercase_map<T>& lowercase_map<T>::operator =(const tsl::ordered_map<std::string, T>& map) {
+	template <class T, class C>
+	lowercase_map<T, C>& lowercase_map<T, C>::operator =(const typename lowercase_map<T, C>::map_type& map) {
 
 		this -> _m.clear();
 		for ( auto& [key, value] : map )
@@ -232,199 +303,376 @@ namespace common {
 		return *this;
 	}
 
-	template <class T>
-	lowercase_map<T>& lowercase_map<T>::operator =(const std::pair<std::string, T>& pair) {
+	template <class T, class C>
+	lowercase_map<T, C>& lowercase_map<T, C>::operator =(const std::pair<std::string, T>& pair) {
 
 		this -> _m.clear();
 		this -> _m[common::to_lower(std::as_const(pair.first))] = pair.second;
 		return *this;
 	}
 
-	template <class T>
-	lowercase_map<T>& lowercase_map<T>::operator *() {
-		return this;
+	template <class T, class C>
+	lowercase_map<T, C>& lowercase_map<T, C>::operator =(lowercase_map<T, C>&& other) noexcept {
+
+		this -> _m = std::move(other._m);
+		return *this;
 	}
 
-	template <class T>
-	const lowercase_map<T>& lowercase_map<T>::operator*() const {
-		return this;
+	template <class T, class C>
+	lowercase_map<T, C>& lowercase_map<T, C>::operator =(typename lowercase_map<T, C>::map_type&& map) {
+
+		if ( lowercase_map<T, C>::is_lowered(map)) {
+			this -> _m = std::move(map);
+			return *this;
+		}
+
+		this -> _m.clear();
+		this -> _m.reserve(map.size());
+		for ( auto it = map.begin(); it != map.end(); it++ )
+			this -> _m.insert_or_assign(common::to_lower(it -> first), std::move(it.value()));
+		map.clear();
+		return *this;
 	}
 
-	template <class T>
-	lowercase_map<T>* lowercase_map<T>::operator ->() {
+	template <class T, class C>
+	lowercase_map<T, C>& lowercase_map<T, C>::operator *() {
 		return *this;
 	}
 
-	template <class T>
-	const lowercase_map<T>* lowercase_map<T>::operator ->() const {
+	template <class T, class C>
+	const lowercase_map<T, C>& lowercase_map<T, C>::operator*() const {
 		return *this;
 	}
 
-	template <class T>
-	lowercase_map<T>::lowercase_map(const std::initializer_list<std::pair<std::string, T>>& l) {
+	template <class T, class C>
+	lowercase_map<T, C>* lowercase_map<T, C>::operator ->() {
+		return this;
+	}
 
-		for ( auto& [key, value] : l )
-			this -> _m[common::to_lower(std::as_const(key))] = value;
+	template <class T, class C>
+	const lowercase_map<T, C>* lowercase_map<T, C>::operator ->() const {
+		return this;
 	}
 
-	template <class T>
-	lowercase_map<T>::lowercase_map(const lowercase_map<T>& other) {
+	template <class T, class C>
+	lowercase_map<T, C>::lowercase_map(const std::initializer_list<std::pair<std::string, T>>& l) {
 
-		for ( auto& [key, value] : other )
+		for ( auto& [key, value] : l )
 			this -> _m[common::to_lower(std::as_const(key))] = value;
 	}
 
-	template <class T>
-	lowercase_map<T>::lowercase_map(const tsl::ordered_map<std::string, T>& map) {
+	template <class T, class C>
+	lowercase_map<T, C>::lowercase_map(const lowercase_map<T, C>& other) : _m(other._m) {}
+
+	template <class T, class C>
+	lowercase_map<T, C>::lowercase_map(const typename lowercase_map<T, C>::map_type& map) {
 
 		for ( auto& [key, value] : map )
 			this -> _m[common::to_lower(std::as_const(key))] = value;
 	}
 
-	template <class T>
-	lowercase_map<T>::lowercase_map(const std::pair<std::string, T>& pair) {
+	template <class T, class C>
+	lowercase_map<T, C>::lowercase_map(const std::pair<std::string, T>& pair) {
 		this -> _m[common::to_lower(std::as_const(pair.first))] = pair.second;
 	}
 
-	template <class T>
-	T& lowercase_map<T>::at(const std::string& key) {
+	template <class T, class C>
+	lowercase_map<T, C>::lowercase_map(lowercase_map<T, C>&& other) noexcept : _m(std::move(other._m)) {}
+
+	template <class T, class C>
+	lowercase_map<T, C>::lowercase_map(typename lowercase_map<T, C>::map_type&& map) {
+		*this = std::move(map);
+	}
+
+	template <class T, class C>
+	template <class InputIt>
+	lowercase_map<T, C>::lowercase_map(InputIt first, InputIt last) {
+		this -> insert(first, last);
+	}
+
+	template <class T, class C>
+	T& lowercase_map<T, C>::at(const std::string& key) {
 		return this -> _m[common::to_lower(std::as_const(key))];
 	}
 
-	template <class T>
-	const T lowercase_map<T>::at(const std::string& key) const {
+	template <class T, class C>
+	const T lowercase_map<T, C>::at(const std::string& key) const {
 		return this -> _m[common::to_lower(std::as_const(key))];
 	}
 
-	template <class T>
-	bool lowercase_map<T>::contains(const std::string& key) const {
+	template <class T, class C>
+	bool lowercase_map<T, C>::contains(const std::string& key) const {
 		return this -> _m.contains(common::to_lower(std::as_const(key)));
 	}
 
-	template <class T>
-	bool lowercase_map<T>::empty() const {
+	template <class T, class C>
+	bool lowercase_map<T, C>::empty() const {
 		return this -> _m.empty();
 	}
 
-	template <class T>
-	typename lowercase_map<T>::size_type lowercase_map<T>::size() const {
+	template <class T, class C>
+	typename lowercase_map<T, C>::size_type lowercase_map<T, C>::size() const {
 		return this -> _m.size();
 	}
 
-	template <class T>
-	typename lowercase_map<T>::size_type lowercase_map<T>::max_size() const {
+	template <class T, class C>
+	typename lowercase_map<T, C>::size_type lowercase_map<T, C>::max_size() const {
 		return this -> _m.max_size();
 	}
 
-	template <class T>
-	void lowercase_map<T>::insert(const std::initializer_list<std::pair<std::string, T>>& l) {
+	template <class T, class C>
+	void lowercase_map<T, C>::reserve(lowercase_map<T, C>::size_type count) {
+		this -> _m.reserve(count);
+	}
+
+	template <class T, class C>
+	void lowercase_map<T, C>::rehash(lowercase_map<T, C>::size_type count) {
+		this -> _m.rehash(count);
+	}
+
+	template <class T, class C>
+	void lowercase_map<T, C>::insert(const std::initializer_list<std::pair<std::string, T>>& l) {
 
 		for ( auto& [key, value] : l )
 			this -> _m[common::to_lower(std::as_const(key))] = value;
 	}
 
-	template <class T>
-	void lowercase_map<T>::insert(const lowercase_map<T>& other) {
+	template <class T, class C>
+	void lowercase_map<T, C>::insert(const lowercase_map<T, C>& other) {
 
-		for ( auto& [key, value] : other )
-			this -> _m[common::to_lower(std::as_const(key))] = value;
+		for ( auto& [key, value] : other._m )
+			this -> _m.insert_or_assign(key, value);
 	}
 
-	template <class T>
-	void lowercase_map<T>::insert(const std::pair<std::string, T>& pair) {
+	template <class T, class C>
+	void lowercase_map<T, C>::insert(const std::pair<std::string, T>& pair) {
 		this -> _m[common::to_lower(std::as_const(pair.first))] = pair.second;
 	}
 
-	template <class T>
-	void lowercase_map<T>::append(const std::initializer_list<std::pair<std::string, T>>& l) {
+	template <class T, class C>
+	void lowercase_map<T, C>::insert(lowercase_map<T, C>&& other) {
+
+		if ( this -> _m.empty()) {
+			this -> _m = std::move(other._m);
+			return;
+		}
+
+		for ( auto it = other._m.begin(); it != other._m.end(); it++ )
+			this -> _m.insert_or_assign(it -> first, std::move(it.value()));
+		other._m.clear();
+	}
+
+	template <class T, class C>
+	void lowercase_map<T, C>::insert(std::pair<std::string, T>&& pair) {
+		this -> _m.insert_or_assign(lowercase_map<T, C>::lowered(std::move(pair.first)), std::move(pair.second));
+	}
+
+	// accepts any range of pairs with a key convertible to std::string,
+	// such as std::pair<std::string, T> or std::pair<std::string_view, T>
+	template <class T, class C>
+	template <class InputIt>
+	void lowercase_map<T, C>::insert(InputIt first, InputIt last) {
+
+		if constexpr ( std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category> )
+			this -> _m.reserve(this -> _m.size() + std::distance(first, last));
+
+		for ( ; first != last; first++ )
+			this -> _m.insert_or_assign(lowercase_map<T, C>::lowered(std::string(first -> first)), first -> second);
+	}
+
+	// bulk build: replaces content with range whose keys are unique after
+	// lowercasing. Bucket array is sized once and values are never
+	// re-assigned. Keys must be unique, duplicates are caught by assert
+	// in debug builds; otherwise first of them wins, unlike insert().
+	template <class T, class C>
+	template <class InputIt>
+	void lowercase_map<T, C>::assign_unique(InputIt first, InputIt last) {
+
+		this -> _m.clear();
+
+		if constexpr ( std::is_base_of_v<std::forward_iterator_tag, typename std::iterator_traits<InputIt>::iterator_category> )
+			this -> _m.reserve(std::distance(first, last));
+
+		for ( ; first != last; first++ ) {
+
+			[[maybe_unused]] bool inserted = this -> _m.try_emplace(
+				lowercase_map<T, C>::lowered(std::string(first -> first)), first -> second).second;
+			assert(inserted && "assign_unique: duplicate key");
+		}
+	}
+
+	template <class T, class C>
+	template <class... Args>
+	std::pair<typename lowercase_map<T, C>::iterator, bool> lowercase_map<T, C>::emplace(const std::string& key, Args&&... args) {
+		return this -> _m.try_emplace(common::to_lower(key), std::forward<Args>(args)...);
+	}
+
+	template <class T, class C>
+	template <class... Args>
+	std::pair<typename lowercase_map<T, C>::iterator, bool> lowercase_map<T, C>::emplace(std::string&& key, Args&&... args) {
+		return this -> _m.try_emplace(lowercase_map<T, C>::lowered(std::move(key)), std::forward<Args>(args)...);
+	}
+
+	template <class T, class C>
+	template <class... Args>
+	std::pair<typename lowercase_map<T, C>::iterator, bool> lowercase_map<T, C>::try_emplace(const std::string& key, Args&&... args) {
+		return this -> _m.try_emplace(common::to_lower(key), std::forward<Args>(args)...);
+	}
+
+	template <class T, class C>
+	template <class... Args>
+	std::pair<typename lowercase_map<T, C>::iterator, bool> lowercase_map<T, C>::try_emplace(std::string&& key, Args&&... args) {
+		return this -> _m.try_emplace(lowercase_map<T, C>::lowered(std::move(key)), std::forward<Args>(args)...);
+	}
+
+	template <class T, class C>
+	void lowercase_map<T, C>::append(const std::initializer_list<std::pair<std::string, T>>& l) {
 		this -> insert(l);
 	}
 
-	template <class T>
-	void lowercase_map<T>::append(const lowercase_map<T>& other) {
+	template <class T, class C>
+	void lowercase_map<T, C>::append(const lowercase_map<T, C>& other) {
 		this -> insert(other);
 	}
 
-	template <class T>
-	void lowercase_map<T>::append(const std::pair<std::string, T>& pair) {
+	template <class T, class C>
+	void lowercase_map<T, C>::append(const std::pair<std::string, T>& pair) {
 		this -> insert(pair);
 	}
 
-	template <class T>
-	const std::pair<std::string, T>& lowercase_map<T>::front() const {
+	template <class T, class C>
+	void lowercase_map<T, C>::append(lowercase_map<T, C>&& other) {
+		this -> insert(std::move(other));
+	}
+
+	template <class T, class C>
+	void lowercase_map<T, C>::append(std::pair<std::string, T>&& pair) {
+		this -> insert(std::move(pair));
+	}
+
+	template <class T, class C>
+	const std::pair<std::string, T>& lowercase_map<T, C>::front() const {
 		return this -> _m.front();
 	}
 
-	template <class T>
-	const std::pair<std::string, T>& lowercase_map<T>::back() const {
+	template <class T, class C>
+	const std::pair<std::string, T>& lowercase_map<T, C>::back() const {
 		return this -> _m.back();
 	}
 
-	template <class T>
-	bool lowercase_map<T>::insert_at_position(lowercase_map<T>::const_iterator pos, const std::pair<std::string, T>& value) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::insert_at_position(lowercase_map<T, C>::const_iterator pos, const std::pair<std::string, T>& value) {
 		std::pair<std::string, T> p = { common::to_lower(value.first), value.second };
-		return this -> m.insert_at_position(pos.c_it, p).second;
+		return this -> _m.insert_at_position(pos, p).second;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::insert_at_position(lowercase_map<T>::const_iterator pos, std::pair<std::string, T>& value) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::insert_at_position(lowercase_map<T, C>::const_iterator pos, std::pair<std::string, T>& value) {
 		std::pair<std::string, T> p = { common::to_lower(value.first), value.second };
-		return this -> m.insert_at_position(pos.c_it, p).second;
+		return this -> _m.insert_at_position(pos, p).second;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::emplace_at_position(lowercase_map<T>::const_iterator pos, const std::pair<std::string, T>& value) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::emplace_at_position(lowercase_map<T, C>::const_iterator pos, const std::pair<std::string, T>& value) {
 		std::pair<std::string, T> p = { common::to_lower(value.first), value.second };
-		return this -> m.emplace_at_position(pos.c_it, p).second;
+		return this -> _m.emplace_at_position(pos, p).second;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::emplace_at_position(lowercase_map<T>::const_iterator pos, std::pair<std::string, T>& value) {
+	template <class T, class C>
+	bool lowercase_map<T, C>::emplace_at_position(lowercase_map<T, C>::const_iterator pos, std::pair<std::string, T>& value) {
 		std::pair<std::string, T> p = { common::to_lower(value.first), value.second };
-		return this -> m.emplace_at_position(pos.c_it, p).second;
+		return this -> _m.emplace_at_position(pos, p).second;
 	}
 
-	template <class T>
-	bool lowercase_map<T>::rename(const std::string& old_key, const std::string& new_key) {
+	// key is replaced in place, entry keeps its position and no other
+	// entries are moved
+	template <class T, class C>
+	bool lowercase_map<T, C>::rename(const std::string& old_key, const std::string& new_key) {
 		std::string o = common::to_lower(old_key);
 		std::string n = common::to_lower(new_key);
 
-		if ( o == n || !this -> _m.contains(o) || this -> _m.contains(n))
+		if ( o == n )
 			return false;
 
-		if ( auto it = this -> _m.find(o); it != this -> _m.end()) {
+		if ( auto it = this -> _m.find(o); it != this -> _m.end())
+			return this -> _m.replace_key(it, std::move(n));
 
-			std::pair<std::string, T> p = { it -> first, it -> second };
-			p.first = n;
-			this -> _m.emplace_at_position(it, p);
+		return false;
+	}
 
-			if ( this -> _m.contains(o))
-				_m.erase(o);
+	template <class T, class C>
+	typename lowercase_map<T, C>::size_type lowercase_map<T, C>::erase(const std::string& key) {
+		return this -> _m.erase(common::to_lower(std::as_const(key)));
+	}
 
-			return true;
+	template <class T, class C>
+	typename lowercase_map<T, C>::size_type lowercase_map<T, C>::erase(lowercase_map<T, C>::const_iterator pos) {
+		this -> _m.erase(pos);
+		return 1;
+	}
 
-		} else return false;
+	template <class T, class C>
+	typename lowercase_map<T, C>::size_type lowercase_map<T, C>::erase(lowercase_map<T, C>::iterator pos) {
+		this -> _m.erase(pos);
+		return 1;
+	}
 
+	// O(1), but last entry takes place of the erased one
+	template <class T, class C>
+	typename lowercase_map<T, C>::size_type lowercase_map<T, C>::unordered_erase(const std::string& key) {
+		return this -> _m.unordered_erase(common::to_lower(key));
 	}
 
-	template <class T>
-	typename lowercase_map<T>::size_type lowercase_map<T>::erase(const std::string& key) {
-		return this -> _m.erase(common::to_lower(std::as_const(key)));
+	template <class T, class C>
+	typename lowercase_map<T, C>::iterator lowercase_map<T, C>::unordered_erase(lowercase_map<T, C>::iterator pos) {
+		return this -> _m.unordered_erase(pos);
 	}
 
-	template <class T>
-	typename lowercase_map<T>::size_type lowercase_map<T>::erase(lowercase_map<T>::const_iterator pos) {
-		return this -> _m.erase(pos.c_it);
+	template <class T, class C>
+	typename lowercase_map<T, C>::iterator lowercase_map<T, C>::unordered_erase(lowercase_map<T, C>::const_iterator pos) {
+		return this -> _m.unordered_erase(pos);
 	}
 
-	template <class T>
-	typename lowercase_map<T>::size_type lowercase_map<T>::erase(lowercase_map<T>::iterator pos) {
-		return this -> _m.erase(pos.it);
+	template <class T, class C>
+	void lowercase_map<T, C>::pop_back() {
+		this -> _m.pop_back();
 	}
 
-	template <class T>
-	void lowercase_map<T>::clear() {
+	// erases count oldest entries in one pass over the buckets, popping
+	// several entries at once is cheaper than popping them one by one
+	template <class T, class C>
+	void lowercase_map<T, C>::pop_front(lowercase_map<T, C>::size_type count) {
+
+		if ( count > this -> _m.size())
+			count = this -> _m.size();
+
+		if ( count > 0 )
+			this -> _m.erase(this -> _m.cbegin(), this -> _m.cbegin() + count);
+	}
+
+	template <class T, class C>
+	void lowercase_map<T, C>::clear() {
 		this -> _m.clear();
 	}
 
+	template <class T, class C>
+	template <class Serializer>
+	void lowercase_map<T, C>::serialize(Serializer& serializer) const {
+		this -> _m.serialize(serializer);
+	}
+
+	// keys of a serialized lowercase_map are already lowercase,
+	// restore them directly without passing through to_lower
+	template <class T, class C>
+	template <class Deserializer>
+	lowercase_map<T, C> lowercase_map<T, C>::deserialize(Deserializer& deserializer, bool hash_compatible) {
+
+		lowercase_map<T, C> m;
+		m._m = map_type::deserialize(deserializer, hash_compatible);
+		return m;
+	}
+
+	template <class T>
+	using lowercase_vector_map = common::lowercase_map<T, std::vector<std::pair<std::string, T>>>;
+
 } // end of namespace
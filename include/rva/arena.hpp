@@ -0,0 +1,155 @@
+#ifndef RECURSIVE_VARIANT_AUTHORITY_ARENA_HPP
+#define RECURSIVE_VARIANT_AUTHORITY_ARENA_HPP
+#include <cstddef>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "variant.hpp"
+
+namespace rva {
+/**
+ * @brief arena keeps a whole rva::variant tree in one monotonic buffer.
+ *
+ * Recursive containers are declared with std::pmr containers, replace_t
+ * rewrites their allocators together with self_t:
+ *
+ *     using json_t = rva::variant<std::nullptr_t, bool, double, std::pmr::string,
+ *         std::pmr::vector<rva::self_t>, std::pmr::map<std::pmr::string, rva::self_t>>;
+ *
+ * Containers and strings are created through make<T>() / string() so they
+ * allocate from the arena; moving them into a parent keeps their allocator.
+ * Copying does not: a std::pmr container's copy allocates from the default
+ * resource, and so do the copies of its elements, use copy() instead.
+ * Objects constructed with create<T>() live in the arena, those that are
+ * not trivially destructible are destroyed, in reverse order, by release()
+ * and ~arena(). Nested containers only return memory to the arena, which
+ * does nothing, the whole tree is then freed at once. Nothing allocated
+ * from an arena may be used after release().
+ */
+class arena {
+   public:
+    using allocator_type = std::pmr::polymorphic_allocator<std::byte>;
+
+    arena() : resource(std::pmr::new_delete_resource()) {}
+    explicit arena(std::size_t initial_size)
+        : resource(initial_size, std::pmr::new_delete_resource()) {}
+    arena(void* buffer, std::size_t size)
+        : resource(buffer, size, std::pmr::new_delete_resource()) {}
+    arena(arena const&) = delete;
+    arena& operator=(arena const&) = delete;
+    ~arena() { destroy(); }
+
+    std::pmr::memory_resource* memory_resource() noexcept { return &resource; }
+    allocator_type allocator() noexcept { return allocator_type(&resource); }
+
+    /**
+     * @brief construct an allocator-aware value (container, string, ...)
+     * that allocates from this arena.
+     */
+    template <class T, class... Args>
+    T make(Args&&... args) {
+        static_assert(std::uses_allocator_v<T, allocator_type>,
+                      "arena::make needs an allocator-aware type");
+        return T(std::forward<Args>(args)..., allocator());
+    }
+
+    std::pmr::string string(std::string_view s) {
+        return std::pmr::string(s, allocator());
+    }
+
+    /**
+     * @brief construct T inside the arena. Its memory and everything it
+     * allocated from the arena go away with release(), which first runs
+     * its destructor unless T is trivially destructible.
+     */
+    template <class T, class... Args>
+    T& create(Args&&... args) {
+        cleanup* c = nullptr;
+        if constexpr (!std::is_trivially_destructible_v<T>) {
+            c = ::new (resource.allocate(sizeof(cleanup), alignof(cleanup)))
+                cleanup{[](void* o) { static_cast<T*>(o)->~T(); }, nullptr, cleanups};
+        }
+        T* obj = ::new (resource.allocate(sizeof(T), alignof(T)))
+            T(std::forward<Args>(args)...);
+        if (c != nullptr) {
+            c->object = obj;
+            cleanups = c;
+        }
+        return *obj;
+    }
+
+    /**
+     * @brief deep copy of v whose containers and strings, at every level
+     * of an rva::variant tree, allocate from this arena. Values that are
+     * not allocator-aware, such as std::string_view, are copied as is.
+     */
+    template <class T>
+    T copy(T const& v) {
+        if constexpr (is_variant<T>::value) {
+            return std::visit(
+                [this](auto const& alt) {
+                    using A = std::decay_t<decltype(alt)>;
+                    return T(std::in_place_type<A>, copy(alt));
+                },
+                v.get_base());
+        } else if constexpr (is_pair<T>::value) {
+            return T(copy(v.first), copy(v.second));
+        } else if constexpr (std::uses_allocator_v<T, allocator_type>) {
+            if constexpr (needs_deep_copy<T>::value) {
+                T out(allocator());
+                for (auto const& e : v)
+                    out.insert(out.end(), copy(e));
+                return out;
+            } else {
+                return T(v, allocator());
+            }
+        } else {
+            return v;
+        }
+    }
+
+    void release() noexcept {
+        destroy();
+        resource.release();
+    }
+
+   private:
+    struct cleanup {
+        void (*destroy)(void*);
+        void* object;
+        cleanup* next;
+    };
+
+    template <class T>
+    struct is_variant : std::false_type {};
+    template <class... T>
+    struct is_variant<variant<T...>> : std::true_type {};
+
+    template <class T>
+    struct is_pair : std::false_type {};
+    template <class A, class B>
+    struct is_pair<std::pair<A, B>> : std::true_type {};
+
+    // containers of trees or strings, their elements are copied one by one
+    template <class T, class = void>
+    struct needs_deep_copy : std::false_type {};
+    template <class T>
+    struct needs_deep_copy<T, std::void_t<typename T::value_type>>
+        : std::bool_constant<!std::is_trivially_copyable_v<typename T::value_type>> {};
+
+    std::pmr::monotonic_buffer_resource resource;
+    cleanup* cleanups = nullptr;
+
+    void destroy() noexcept {
+        for (cleanup* c = cleanups; c != nullptr; c = c->next)
+            c->destroy(c->object);
+        cleanups = nullptr;
+    }
+};
+} // namespace rva
+
+#endif
@@ -1054,6 +1054,37 @@ class ordered_hash : private Hash, private KeyEqual {
     erase(std::prev(end()));
   }
 
+  /**
+   * Replace the key of the element at 'pos' by 'key', keeping its position in
+   * m_values. Only the bucket of the element is relocated, no value is moved
+   * or shifted. Return false and leave the container unchanged if 'key' is
+   * already present.
+   */
+  template <class K>
+  bool replace_key(const_iterator pos, K&& key) {
+    const std::size_t hash = hash_key(key);
+    if (find_key(key, hash) != m_buckets_data.end()) {
+      return false;
+    }
+
+    auto it_bucket = find_key(pos.key(), hash_key(pos.key()));
+    tsl_oh_assert(it_bucket != m_buckets_data.end());
+
+    typename KeySelect::key_type new_key(std::forward<K>(key));
+    const index_type index = it_bucket->index();
+
+    // Everything should be noexcept from here.
+    it_bucket->clear();
+    backward_shift(
+        std::size_t(std::distance(m_buckets_data.begin(), it_bucket)));
+
+    KeySelect()(m_values[index]) = std::move(new_key);
+    insert_index(bucket_for_hash(hash), 0, index,
+                 bucket_entry::truncate_hash(hash));
+
+    return true;
+  }
+
   /**
    * Here to avoid `template<class K> size_type unordered_erase(const K& key)`
    * being used when we use a iterator instead of a const_iterator.
@@ -853,6 +853,24 @@ class ordered_map {
 
   void pop_back() { m_ht.pop_back(); }
 
+  /**
+   * Replace the key of the element at 'pos' by 'k' without changing its
+   * position in the insertion order, in O(1) average complexity. Only the
+   * bucket array is updated, the other values are not shifted.
+   *
+   * Return false and leave the map unchanged if 'k' is already in the map.
+   */
+  bool replace_key(const_iterator pos, const key_type& k) {
+    return m_ht.replace_key(pos, k);
+  }
+
+  /**
+   * @copydoc replace_key(const_iterator pos, const key_type& k)
+   */
+  bool replace_key(const_iterator pos, key_type&& k) {
+    return m_ht.replace_key(pos, std::move(k));
+  }
+
   /**
    * Faster erase operation with an O(1) average complexity but it doesn't
    * preserve the insertion order.
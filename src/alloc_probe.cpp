@@ -0,0 +1,159 @@
+#include <ostream>
+#include <iomanip>
+#include <vector>
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "common/alloc_probe.hpp"
+
+#ifdef COMMON_ALLOC_PROBES
+
+// plain thread_local integers, no constructors, safe to use from operator new
+static thread_local uint64_t thread_allocs = 0;
+static thread_local uint64_t thread_bytes = 0;
+static std::atomic<common::alloc::site*> sites{nullptr};
+
+static void* counted_alloc(std::size_t size) noexcept {
+
+	thread_allocs++;
+	thread_bytes += size;
+	return std::malloc(size == 0 ? 1 : size);
+}
+
+void* operator new(std::size_t size) {
+
+	if ( void* p = counted_alloc(size))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+	return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+	return counted_alloc(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+	return counted_alloc(size);
+}
+
+// over-aligned types, alignas(64) queues and counter cells among them
+static void* counted_aligned_alloc(std::size_t size, std::align_val_t align) noexcept {
+
+	std::size_t a = static_cast<std::size_t>(align);
+
+	thread_allocs++;
+	thread_bytes += size;
+
+	// aligned_alloc wants size to be a multiple of alignment
+	return std::aligned_alloc(a, size == 0 ? a : ( size + a - 1 ) & ~( a - 1 ));
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+
+	if ( void* p = counted_aligned_alloc(size, align))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+	return ::operator new(size, align);
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+	return counted_aligned_alloc(size, align);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+	return counted_aligned_alloc(size, align);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+common::alloc::site::site(const char* name) : name(name), next(sites.load(std::memory_order_relaxed)) {
+
+	while ( !sites.compare_exchange_weak(this -> next, this, std::memory_order_release, std::memory_order_relaxed));
+}
+
+void common::alloc::site::add(const common::alloc::counters& c) {
+
+	this -> calls.fetch_add(1, std::memory_order_relaxed);
+	this -> allocs.fetch_add(c.allocs, std::memory_order_relaxed);
+	this -> bytes.fetch_add(c.bytes, std::memory_order_relaxed);
+}
+
+common::alloc::counters common::alloc::thread_counters() {
+
+	return { thread_allocs, thread_bytes };
+}
+
+std::vector<common::alloc::stats> common::alloc::report() {
+
+	std::vector<common::alloc::stats> v;
+
+	for ( common::alloc::site* s = sites.load(std::memory_order_acquire); s != nullptr; s = s -> next )
+		v.push_back({ s -> name, s -> calls.load(std::memory_order_relaxed),
+			s -> allocs.load(std::memory_order_relaxed), s -> bytes.load(std::memory_order_relaxed) });
+
+	std::sort(v.begin(), v.end(), [](const common::alloc::stats& a, const common::alloc::stats& b) {
+		return a.bytes > b.bytes;
+	});
+
+	return v;
+}
+
+void common::alloc::reset() {
+
+	for ( common::alloc::site* s = sites.load(std::memory_order_acquire); s != nullptr; s = s -> next ) {
+		s -> calls.store(0, std::memory_order_relaxed);
+		s -> allocs.store(0, std::memory_order_relaxed);
+		s -> bytes.store(0, std::memory_order_relaxed);
+	}
+}
+
+#else
+
+common::alloc::counters common::alloc::thread_counters() {
+
+	return {};
+}
+
+std::vector<common::alloc::stats> common::alloc::report() {
+
+	return {};
+}
+
+void common::alloc::reset() {}
+
+#endif
+
+void common::alloc::dump(std::ostream& os) {
+
+	std::vector<common::alloc::stats> v = common::alloc::report();
+
+	os << std::setw(10) << "calls" << std::setw(12) << "allocs" << std::setw(14) << "bytes" <<
+		std::setw(12) << "allocs/call" << std::setw(12) << "bytes/call" << "  function" << std::endl;
+
+	for ( const common::alloc::stats& s : v ) {
+
+		if ( s.calls == 0 )
+			continue;
+
+		os << std::setw(10) << s.calls << std::setw(12) << s.allocs << std::setw(14) << s.bytes <<
+			std::setw(12) << std::fixed << std::setprecision(2) << (double)s.allocs / s.calls <<
+			std::setw(12) << std::setprecision(1) << (double)s.bytes / s.calls << "  " << s.name << std::endl;
+	}
+}
@@ -0,0 +1,383 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "common/batch_read.hpp"
+#include "common/trace.hpp"
+
+// minimal io_uring over raw syscalls, only what batch_reader needs
+struct common::batch_reader::uring {
+
+	int fd = -1;
+	unsigned entries = 0;
+
+	void* sq_ptr = MAP_FAILED;
+	size_t sq_len = 0;
+	void* cq_ptr = MAP_FAILED;
+	size_t cq_len = 0;
+	io_uring_sqe* sqes = (io_uring_sqe*)MAP_FAILED;
+	size_t sqes_len = 0;
+
+	unsigned* sq_head;
+	unsigned* sq_tail;
+	unsigned* sq_mask;
+	unsigned* sq_array;
+	unsigned* cq_head;
+	unsigned* cq_tail;
+	unsigned* cq_mask;
+	io_uring_cqe* cqes;
+
+	unsigned queued = 0; // in submission queue, not yet taken by kernel
+	unsigned inflight = 0; // taken by kernel, not yet completed
+
+	bool setup(unsigned depth) {
+
+		io_uring_params p;
+		std::memset(&p, 0, sizeof(p));
+
+		if (( this -> fd = ::syscall(__NR_io_uring_setup, depth, &p)) < 0 )
+			return false;
+
+		this -> entries = p.sq_entries;
+		this -> sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+		this -> cq_len = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+
+		if ( p.features & IORING_FEAT_SINGLE_MMAP )
+			this -> sq_len = this -> cq_len = std::max(this -> sq_len, this -> cq_len);
+
+		this -> sq_ptr = ::mmap(nullptr, this -> sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this -> fd, IORING_OFF_SQ_RING);
+		if ( this -> sq_ptr == MAP_FAILED )
+			return false;
+
+		if ( p.features & IORING_FEAT_SINGLE_MMAP )
+			this -> cq_ptr = this -> sq_ptr;
+		else if (( this -> cq_ptr = ::mmap(nullptr, this -> cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this -> fd, IORING_OFF_CQ_RING)) == MAP_FAILED )
+			return false;
+
+		this -> sqes_len = p.sq_entries * sizeof(io_uring_sqe);
+		this -> sqes = (io_uring_sqe*)::mmap(nullptr, this -> sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, this -> fd, IORING_OFF_SQES);
+		if ( this -> sqes == MAP_FAILED )
+			return false;
+
+		char* sq = (char*)this -> sq_ptr;
+		char* cq = (char*)this -> cq_ptr;
+		this -> sq_head = (unsigned*)( sq + p.sq_off.head );
+		this -> sq_tail = (unsigned*)( sq + p.sq_off.tail );
+		this -> sq_mask = (unsigned*)( sq + p.sq_off.ring_mask );
+		this -> sq_array = (unsigned*)( sq + p.sq_off.array );
+		this -> cq_head = (unsigned*)( cq + p.cq_off.head );
+		this -> cq_tail = (unsigned*)( cq + p.cq_off.tail );
+		this -> cq_mask = (unsigned*)( cq + p.cq_off.ring_mask );
+		this -> cqes = (io_uring_cqe*)( cq + p.cq_off.cqes );
+		return true;
+	}
+
+	~uring() {
+
+		if ( this -> sqes != MAP_FAILED )
+			::munmap(this -> sqes, this -> sqes_len);
+		if ( this -> cq_ptr != MAP_FAILED && this -> cq_ptr != this -> sq_ptr )
+			::munmap(this -> cq_ptr, this -> cq_len);
+		if ( this -> sq_ptr != MAP_FAILED )
+			::munmap(this -> sq_ptr, this -> sq_len);
+		if ( this -> fd >= 0 )
+			::close(this -> fd);
+	}
+
+	// caller never queues more than entries before calling wait()
+	io_uring_sqe* next(uint8_t opcode, uint64_t user_data) {
+
+		unsigned tail = *this -> sq_tail;
+		unsigned idx = tail & *this -> sq_mask;
+		io_uring_sqe* sqe = &this -> sqes[idx];
+
+		std::memset(sqe, 0, sizeof(*sqe));
+		sqe -> opcode = opcode;
+		sqe -> user_data = user_data;
+		this -> sq_array[idx] = idx;
+		__atomic_store_n(this -> sq_tail, tail + 1, __ATOMIC_RELEASE);
+		this -> queued++;
+		return sqe;
+	}
+
+	// submits queued entries and calls f(user_data, res) for each completion,
+	// on failure counters still tell what is outstanding
+	template<typename F>
+	bool wait(F f) {
+
+		while ( this -> queued + this -> inflight > 0 ) {
+
+			int r = ::syscall(__NR_io_uring_enter, this -> fd, this -> queued, this -> queued + this -> inflight, IORING_ENTER_GETEVENTS, nullptr, 0);
+
+			if ( r < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY )
+				return false;
+
+			if ( r > 0 ) {
+				unsigned n = std::min((unsigned)r, this -> queued);
+				this -> queued -= n;
+				this -> inflight += n;
+			}
+
+			unsigned head = *this -> cq_head;
+			unsigned tail = __atomic_load_n(this -> cq_tail, __ATOMIC_ACQUIRE);
+
+			for ( ; head != tail; head++ ) {
+				const io_uring_cqe& cqe = this -> cqes[head & *this -> cq_mask];
+				this -> inflight--;
+				f(cqe.user_data, cqe.res);
+			}
+
+			__atomic_store_n(this -> cq_head, head, __ATOMIC_RELEASE);
+		}
+
+		return true;
+	}
+
+	// takes back entries kernel has not consumed and waits for the rest,
+	// false if completions could not be collected
+	template<typename F>
+	bool abandon(F f) {
+
+		unsigned head = __atomic_load_n(this -> sq_head, __ATOMIC_ACQUIRE);
+		unsigned unsubmitted = *this -> sq_tail - head;
+
+		this -> inflight += this -> queued - std::min(unsubmitted, this -> queued);
+		this -> queued = 0;
+		__atomic_store_n(this -> sq_tail, head, __ATOMIC_RELEASE);
+
+		return this -> wait(f);
+	}
+};
+
+common::batch_reader::batch_reader(unsigned depth, bool use_io_uring) : depth(depth == 0 ? 1 : depth) {
+
+	if ( !use_io_uring )
+		return;
+
+	this -> ring = std::make_unique<uring>();
+
+	if ( !this -> ring -> setup(this -> depth))
+		this -> ring.reset();
+	else this -> depth = this -> ring -> entries;
+}
+
+common::batch_reader::~batch_reader() {}
+
+size_t common::batch_reader::add(const std::string& path, size_t size_hint) {
+
+	if ( this -> used == this -> files.size())
+		this -> files.emplace_back();
+
+	file& f = this -> files[this -> used];
+	f.path = path;
+	f.fd = -1;
+	f.owned = true;
+	f.length = 0;
+	f.error = 0;
+
+	if ( f.buf.size() < size_hint )
+		f.buf.resize(size_hint);
+
+	return this -> used++;
+}
+
+size_t common::batch_reader::add_fd(int fd, size_t size_hint) {
+
+	size_t i = this -> add(std::string(), size_hint);
+	this -> files[i].fd = fd;
+	this -> files[i].owned = false;
+	return i;
+}
+
+void common::batch_reader::clear() {
+
+	this -> used = 0;
+}
+
+std::string_view common::batch_reader::data(size_t i) const {
+
+	const file& f = this -> files[i];
+	return f.error == 0 ? std::string_view(f.buf.data(), f.length) : std::string_view();
+}
+
+// file filled its buffer, re-read it with a larger one
+void common::batch_reader::grow(common::batch_reader::file& f) {
+
+	while ( f.error == 0 && f.length == f.buf.size()) {
+
+		f.buf.resize(f.buf.size() * 2);
+		ssize_t len = ::pread(f.fd, f.buf.data(), f.buf.size(), 0);
+
+		if ( len < 0 )
+			f.error = errno;
+		else f.length = len;
+	}
+}
+
+void common::batch_reader::read_sync(common::batch_reader::file& f) {
+
+	if ( f.owned && ( f.fd = ::open(f.path.c_str(), O_RDONLY | O_CLOEXEC)) < 0 ) {
+		f.error = errno;
+		return;
+	}
+
+	ssize_t len = ::pread(f.fd, f.buf.data(), f.buf.size(), 0);
+
+	if ( len < 0 )
+		f.error = errno;
+	else {
+		f.length = len;
+		this -> grow(f);
+	}
+
+	if ( f.owned ) {
+		::close(f.fd);
+		f.fd = -1;
+	}
+}
+
+// user_data of ring entries: opcode in high half, file index in low half
+void common::batch_reader::complete(uint64_t data, int res) {
+
+	file& f = this -> files[data & 0xffffffff];
+
+	switch ( data >> 32 ) {
+
+		case IORING_OP_OPENAT:
+			if ( res == -EINVAL ) this -> unsupported = true;
+			else if ( res < 0 ) f.error = -res;
+			else f.fd = res;
+			break;
+
+		case IORING_OP_READ:
+			if ( res < 0 ) f.error = -res;
+			else f.length = res;
+			break;
+
+		// close can not meaningfully fail for a read-only descriptor
+		case IORING_OP_CLOSE:
+			f.fd = -1;
+			break;
+	}
+}
+
+// ring failed mid-batch: collect outstanding completions and close what
+// ring opened, so batch can be read again synchronously
+bool common::batch_reader::abandon_ring(size_t first, size_t last) {
+
+	if ( this -> ring -> abandon([this](uint64_t data, int res) { this -> complete(data, res); })) {
+
+		for ( size_t i = first; i < last; i++ )
+			if ( this -> files[i].owned && this -> files[i].fd >= 0 ) {
+				::close(this -> files[i].fd);
+				this -> files[i].fd = -1;
+			}
+
+		return false;
+	}
+
+	// reads may still land in buffers of this batch, give it new ones. Which
+	// descriptors are still open is unknown, they are left alone rather
+	// than risking closing one reused elsewhere.
+	for ( size_t i = first; i < last; i++ ) {
+		file& f = this -> files[i];
+		size_t size = f.buf.size();
+		this -> retired.push_back(std::move(f.buf));
+		f.buf.assign(size, 0);
+	}
+
+	return false;
+}
+
+// one batch of opens, reads and closes, false if ring can not be used
+bool common::batch_reader::submit_ring(size_t first, size_t last) {
+
+	uring& r = *this -> ring;
+	auto done = [this](uint64_t data, int res) { this -> complete(data, res); };
+
+	this -> unsupported = false;
+
+	for ( size_t i = first; i < last; i++ ) {
+
+		if ( !this -> files[i].owned )
+			continue;
+
+		io_uring_sqe* sqe = r.next(IORING_OP_OPENAT, ((uint64_t)IORING_OP_OPENAT << 32 ) | i);
+		sqe -> fd = AT_FDCWD;
+		sqe -> addr = (uint64_t)this -> files[i].path.c_str();
+		sqe -> open_flags = O_RDONLY | O_CLOEXEC;
+	}
+
+	if ( !r.wait(done) || this -> unsupported )
+		return this -> abandon_ring(first, last);
+
+	for ( size_t i = first; i < last; i++ ) {
+
+		file& f = this -> files[i];
+
+		if ( f.error != 0 )
+			continue;
+
+		io_uring_sqe* sqe = r.next(IORING_OP_READ, ((uint64_t)IORING_OP_READ << 32 ) | i);
+		sqe -> fd = f.fd;
+		sqe -> addr = (uint64_t)f.buf.data();
+		sqe -> len = f.buf.size();
+		sqe -> off = 0;
+	}
+
+	if ( !r.wait(done))
+		return this -> abandon_ring(first, last);
+
+	for ( size_t i = first; i < last; i++ ) {
+
+		file& f = this -> files[i];
+		this -> grow(f);
+
+		if ( f.owned && f.fd >= 0 ) {
+			io_uring_sqe* sqe = r.next(IORING_OP_CLOSE, ((uint64_t)IORING_OP_CLOSE << 32 ) | i);
+			sqe -> fd = f.fd;
+		}
+	}
+
+	if ( !r.wait(done))
+		return this -> abandon_ring(first, last);
+
+	return true;
+}
+
+void common::batch_reader::submit() {
+
+	COMMON_TRACE_SCOPE("common::batch_reader::submit");
+
+	for ( size_t first = 0; first < this -> used; first += this -> depth ) {
+
+		size_t last = std::min(this -> used, first + this -> depth);
+
+		if ( this -> ring && this -> submit_ring(first, last))
+			continue;
+
+		// io_uring unavailable or failed, (re-)read batch synchronously;
+		// submit_ring has closed what it opened
+		this -> ring.reset();
+
+		for ( size_t i = first; i < last; i++ ) {
+
+			file& f = this -> files[i];
+
+			if ( f.owned )
+				f.fd = -1;
+
+			f.length = 0;
+			f.error = 0;
+			this -> read_sync(f);
+		}
+	}
+}
@@ -0,0 +1,355 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <algorithm>
+#include <charconv>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/resource.h>
+
+#include "common/cgroup.hpp"
+#include "common/trace.hpp"
+
+namespace {
+
+	const int fd_absent = -2;
+}
+
+common::cgroup_reader::cgroup_reader(const std::string& root, const std::vector<std::string>& files, size_t max_open) :
+		root(root), files(files), file_cols(files.size()), buf(4096), fd_budget(max_open) {
+
+	this -> root_fd = ::open(root.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if ( this -> root_fd < 0 )
+		throw std::runtime_error("failed to open " + root + ": " + std::strerror(errno));
+
+	// rest of descriptor table belongs to the application
+	struct rlimit rl;
+	if ( ::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur / 4 < this -> fd_budget )
+		this -> fd_budget = rl.rlim_cur / 4;
+}
+
+common::cgroup_reader::~cgroup_reader() {
+
+	for ( row& r : this -> rows )
+		this -> close_row(r);
+
+	if ( this -> root_fd >= 0 )
+		::close(this -> root_fd);
+}
+
+void common::cgroup_reader::close_row(common::cgroup_reader::row& r) {
+
+	for ( int& fd : r.fds ) {
+
+		if ( fd >= 0 ) {
+			::close(fd);
+			this -> persistent--;
+		}
+
+		fd = -1;
+	}
+}
+
+ssize_t common::cgroup_reader::find(std::string_view path) const {
+
+	auto it = this -> index.find(std::string(path));
+	return it == this -> index.end() ? -1 : (ssize_t)it -> second;
+}
+
+ssize_t common::cgroup_reader::column(std::string_view file, std::string_view key) const {
+
+	for ( size_t c = 0; c < this -> cols.size(); c++ )
+		if ( this -> cols[c].key == key && this -> files[this -> cols[c].file] == file )
+			return c;
+
+	return -1;
+}
+
+long long common::cgroup_reader::delta(size_t column, size_t row) const {
+
+	return (long long)this -> cols[column].values[row] - (long long)this -> cols[column].previous[row];
+}
+
+void common::cgroup_reader::walk(int dir_fd, const std::string& path) {
+
+	if ( auto it = this -> index.find(path); it != this -> index.end()) {
+
+		row& r = this -> rows[it -> second];
+		r.generation = this -> generation;
+
+		// controllers may have been enabled since
+		std::replace(r.fds.begin(), r.fds.end(), fd_absent, -1);
+
+	} else {
+
+		row r;
+		r.path = path;
+		r.fds.assign(this -> files.size(), -1);
+		r.generation = this -> generation;
+
+		this -> index.emplace(path, this -> rows.size());
+		this -> rows.push_back(std::move(r));
+
+		for ( col& c : this -> cols ) {
+			c.values.emplace_back(0);
+			c.previous.emplace_back(0);
+		}
+	}
+
+	DIR* dir = ::fdopendir(dir_fd);
+
+	if ( dir == nullptr ) {
+		::close(dir_fd);
+		return;
+	}
+
+	while ( struct dirent* d = ::readdir(dir)) {
+
+		if ( d -> d_type != DT_DIR || d -> d_name[0] == '.' )
+			continue;
+
+		int fd = ::openat(::dirfd(dir), d -> d_name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+		if ( fd >= 0 )
+			this -> walk(fd, ( path == "/" ? path : path + "/" ) + d -> d_name);
+	}
+
+	::closedir(dir);
+}
+
+void common::cgroup_reader::rescan() {
+
+	COMMON_TRACE_SCOPE("common::cgroup_reader::rescan");
+
+	this -> generation++;
+
+	int fd = ::dup(this -> root_fd);
+	if ( fd < 0 )
+		throw std::runtime_error(std::string("failed to rescan cgroups: ") + std::strerror(errno));
+
+	// readdir continues from descriptor's offset, shared with root_fd
+	::lseek(fd, 0, SEEK_SET);
+	this -> walk(fd, "/");
+
+	for ( row& r : this -> rows )
+		if ( r.generation != this -> generation )
+			r.gone = true;
+
+	this -> remove_gone();
+}
+
+void common::cgroup_reader::remove_gone() {
+
+	size_t kept = 0;
+
+	for ( size_t i = 0; i < this -> rows.size(); i++ ) {
+
+		if ( this -> rows[i].gone ) {
+			this -> close_row(this -> rows[i]);
+			continue;
+		}
+
+		if ( kept != i ) {
+
+			this -> rows[kept] = std::move(this -> rows[i]);
+
+			for ( col& c : this -> cols ) {
+				c.values[kept] = c.values[i];
+				c.previous[kept] = c.previous[i];
+			}
+		}
+
+		kept++;
+	}
+
+	if ( kept == this -> rows.size())
+		return;
+
+	this -> rows.resize(kept);
+
+	for ( col& c : this -> cols ) {
+		c.values.resize(kept);
+		c.previous.resize(kept);
+	}
+
+	this -> index.clear();
+
+	for ( size_t i = 0; i < this -> rows.size(); i++ )
+		this -> index.emplace(this -> rows[i].path, i);
+}
+
+// reads file of row into buf, returns length or -1; retry is set when
+// file could not be opened for now, out of descriptors or memory
+ssize_t common::cgroup_reader::read_file(common::cgroup_reader::row& r, size_t file, bool& retry) {
+
+	int fd = r.fds[file];
+	retry = false;
+
+	if ( fd == fd_absent )
+		return -1;
+
+	if ( fd < 0 ) {
+
+		std::string rel = r.path == "/" ? this -> files[file] : r.path.substr(1) + "/" + this -> files[file];
+
+		if (( fd = ::openat(this -> root_fd, rel.c_str(), O_RDONLY | O_CLOEXEC)) < 0 ) {
+
+			// cgroup is gone when its directory is, file is absent until next
+			// rescan when its controller is not enabled or it is not readable
+			if ( errno == ENOENT && ::faccessat(this -> root_fd, r.path == "/" ? "." : r.path.c_str() + 1, F_OK, 0) != 0 )
+				r.gone = true;
+			else if ( errno == ENOENT || errno == EACCES || errno == EPERM )
+				r.fds[file] = fd_absent;
+			else retry = true;
+
+			return -1;
+		}
+
+		if ( this -> persistent < this -> fd_budget ) {
+			r.fds[file] = fd;
+			this -> persistent++;
+		}
+	}
+
+	ssize_t len;
+
+	while (( len = ::pread(fd, this -> buf.data(), this -> buf.size(), 0)) == (ssize_t)this -> buf.size())
+		this -> buf.resize(this -> buf.size() * 2);
+
+	if ( r.fds[file] != fd )
+		::close(fd);
+
+	// files of a removed cgroup fail with ENODEV
+	if ( len < 0 )
+		r.gone = true;
+
+	return len;
+}
+
+size_t common::cgroup_reader::column_for(size_t file, std::string_view key, size_t& hint) {
+
+	std::vector<size_t>& fc = this -> file_cols[file];
+
+	if ( hint < fc.size() && this -> cols[fc[hint]].key == key )
+		return fc[hint++];
+
+	for ( size_t i = 0; i < fc.size(); i++ )
+		if ( this -> cols[fc[i]].key == key ) {
+			hint = i + 1;
+			return fc[i];
+		}
+
+	col c;
+	c.file = file;
+	c.key = key;
+	c.values.assign(this -> rows.size(), 0);
+	c.previous.assign(this -> rows.size(), 0);
+
+	this -> cols.push_back(std::move(c));
+	fc.push_back(this -> cols.size() - 1);
+	hint = fc.size();
+	return this -> cols.size() - 1;
+}
+
+// "key value" lines, or "device key=value key=value ..." lines summed over devices
+void common::cgroup_reader::parse(size_t file, size_t row, size_t len) {
+
+	std::string_view data(this -> buf.data(), len);
+	size_t hint = 0;
+
+	while ( !data.empty()) {
+
+		size_t eol = data.find('\n');
+		std::string_view line = data.substr(0, eol);
+		data.remove_prefix(eol == std::string_view::npos ? data.size() : eol + 1);
+
+		size_t sp = line.find(' ');
+		if ( sp == std::string_view::npos )
+			continue;
+
+		std::string_view first = line.substr(0, sp);
+		std::string_view rest = line.substr(sp + 1);
+
+		if ( rest.find('=') == std::string_view::npos ) {
+
+			uint64_t v;
+			if ( std::from_chars(rest.data(), rest.data() + rest.size(), v).ec == std::errc())
+				this -> cols[this -> column_for(file, first, hint)].values[row] = v;
+
+			continue;
+		}
+
+		hint = 0;
+
+		while ( !rest.empty()) {
+
+			size_t end = rest.find(' ');
+			std::string_view token = rest.substr(0, end);
+			rest.remove_prefix(end == std::string_view::npos ? rest.size() : end + 1);
+
+			size_t eq = token.find('=');
+			if ( eq == std::string_view::npos )
+				continue;
+
+			uint64_t v;
+			if ( std::from_chars(token.data() + eq + 1, token.data() + token.size(), v).ec == std::errc())
+				this -> cols[this -> column_for(file, token.substr(0, eq), hint)].values[row] += v;
+		}
+	}
+}
+
+void common::cgroup_reader::sample() {
+
+	COMMON_TRACE_SCOPE("common::cgroup_reader::sample");
+
+	if ( this -> samples == 0 )
+		this -> rescan();
+
+	auto now = std::chrono::steady_clock::now();
+	this -> elapsed = this -> samples == 0 ? std::chrono::nanoseconds(0) : std::chrono::duration_cast<std::chrono::nanoseconds>(now - this -> last);
+	this -> last = now;
+
+	for ( col& c : this -> cols ) {
+		std::swap(c.values, c.previous);
+		std::fill(c.values.begin(), c.values.end(), 0);
+	}
+
+	for ( size_t i = 0; i < this -> rows.size(); i++ ) {
+
+		for ( size_t f = 0; f < this -> files.size() && !this -> rows[i].gone; f++ ) {
+
+			bool retry;
+			ssize_t len = this -> read_file(this -> rows[i], f, retry);
+
+			if ( len > 0 )
+				this -> parse(f, i, len);
+			else if ( retry )
+				for ( size_t c : this -> file_cols[f] )
+					this -> cols[c].values[i] = this -> cols[c].previous[i];
+		}
+	}
+
+	// nothing to compare against for new cgroups and keys
+	for ( col& c : this -> cols ) {
+
+		if ( c.fresh )
+			c.previous = c.values;
+		else
+			for ( size_t i = 0; i < this -> rows.size(); i++ )
+				if ( this -> rows[i].fresh )
+					c.previous[i] = c.values[i];
+
+		c.fresh = false;
+	}
+
+	for ( row& r : this -> rows )
+		r.fresh = false;
+
+	this -> remove_gone();
+	this -> samples++;
+}
@@ -0,0 +1,80 @@
+#include <chrono>
+#include <cstdint>
+#include <utility>
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#endif
+
+#include "common/clock.hpp"
+
+common::clock::coarse::duration common::clock::coarse::resolution() noexcept {
+
+	struct timespec ts;
+
+	if ( ::clock_getres(CLOCK_MONOTONIC_COARSE, &ts) != 0 )
+		return duration(0);
+
+	return duration((rep)ts.tv_sec * 1000000000 + ts.tv_nsec);
+}
+
+static bool invariant_tsc() {
+
+#if defined(__x86_64__) || defined(__i386__)
+	unsigned int eax, ebx, ecx, edx;
+
+	if ( __get_cpuid_max(0x80000000, nullptr) < 0x80000007 )
+		return false;
+
+	__cpuid(0x80000007, eax, ebx, ecx, edx);
+	return edx & ( 1 << 8 );
+#else
+	return false;
+#endif
+}
+
+// counts cycles over ~10ms of monotonic clock, takes median of 3 rounds
+common::clock::tsc::calibration common::clock::tsc::calibrate() noexcept {
+
+	common::clock::tsc::calibration c = { false, 0, 0, 0 };
+
+	if ( !invariant_tsc())
+		return c;
+
+	uint64_t mults[3];
+	int64_t t1 = 0;
+	uint64_t c1 = 0;
+
+	for ( uint64_t& mult : mults ) {
+
+		int64_t t0 = common::clock::monotonic::now().time_since_epoch().count();
+		uint64_t c0 = tsc::raw_cycles();
+
+		do {
+			t1 = common::clock::monotonic::now().time_since_epoch().count();
+			c1 = tsc::raw_cycles();
+		} while ( t1 - t0 < 10000000 );
+
+		if ( c1 <= c0 )
+			return c;
+
+		mult = (uint64_t)((( (unsigned __int128)( t1 - t0 )) << 32 ) / ( c1 - c0 ));
+	}
+
+	if ( mults[0] > mults[1] ) std::swap(mults[0], mults[1]);
+	if ( mults[1] > mults[2] ) std::swap(mults[1], mults[2]);
+	if ( mults[0] > mults[1] ) std::swap(mults[0], mults[1]);
+
+	c.available = mults[1] != 0;
+	c.base_cycles = c1;
+	c.base_ns = t1;
+	c.mult = mults[1];
+	return c;
+}
+
+double common::clock::tsc::frequency() noexcept {
+
+	const calibration& c = tsc::params();
+	return c.available ? 4294967296.0 * 1e9 / c.mult : 0;
+}
@@ -10,6 +10,9 @@
 
 #include "common.hpp"
 #include "lowercase_map.hpp"
+#include "common/alloc_probe.hpp"
+#include "common/trace.hpp"
+#include "common/metrics.hpp"
 
 uint64_t common::mix(const char& m, const uint64_t& s) {
 	return ((s<<7) + ~(s>>3)) + ~m;
@@ -21,6 +24,8 @@ uint64_t common::hash(const char *m) {
 
 std::string common::to_string(common::char_type& ch) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::string s;
 	s += ch;
 	return s;
@@ -54,6 +59,8 @@ std::string str_first(const std::string& str, const common::char_type& delim) {
 
 std::string common::trimmed(std::string& str, const std::string& trimchars) {
 
+	COMMON_ALLOC_PROBE();
+
 	if ( str.empty() || trimchars.empty())
 		return str;
 
@@ -65,12 +72,16 @@ std::string common::trimmed(std::string& str, const std::string& trimchars) {
 
 std::string common::trimmed(const std::string& str, const std::string& trimchars) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::string s = str;
 	return common::trimmed(s, trimchars);
 }
 
 std::vector<std::string> common::lines(const std::string& str, const std::string& delim, const std::string& trimchars) {
 
+	COMMON_ALLOC_PROBE();
+
 	if ( str.empty())
 		return {};
 
@@ -94,11 +105,15 @@ std::vector<std::string> common::lines(const std::string& str, const std::string
 
 std::vector<std::string> common::lines(const std::string& str, const common::char_type& delim, const std::string& trimchars) {
 
+	COMMON_ALLOC_PROBE();
+
 	return common::lines(str, common::to_string(delim), trimchars);
 }
 
 std::vector<std::string> common::split(const std::string& str, const std::string& delim, const std::string& trimchars) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::vector<std::string> vec = common::lines(str, delim, trimchars);
 	vec.erase(std::remove_if(vec.begin(), vec.end(), [](const std::string& s) { return s.empty(); }), vec.end());
 	return vec;
@@ -106,6 +121,8 @@ std::vector<std::string> common::split(const std::string& str, const std::string
 
 std::vector<std::string> common::split(const std::string& str, const common::char_type& delim, const std::string& trimchars) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::vector<std::string> vec = common::lines(str, delim, trimchars);
 	vec.erase(std::remove_if(vec.begin(), vec.end(), [](const std::string& s) { return s.empty(); }), vec.end());
 	return vec;
@@ -113,6 +130,8 @@ std::vector<std::string> common::split(const std::string& str, const common::cha
 
 std::string common::to_lower(std::string& str) {
 
+	COMMON_ALLOC_PROBE();
+
 	for ( auto& ch : str )
 		if ( std::isupper(ch))
 			ch ^= 32;
@@ -121,12 +140,16 @@ std::string common::to_lower(std::string& str) {
 
 std::string common::to_lower(const std::string& str) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::string s = str;
 	return common::to_lower(s);
 }
 
 std::string common::to_upper(std::string& str) {
 
+	COMMON_ALLOC_PROBE();
+
 	for ( auto& ch : str )
 		if ( std::islower(ch))
 			ch &= ~32;
@@ -134,6 +157,8 @@ std::string common::to_upper(std::string& str) {
 }
 
 std::string common::to_upper(const std::string& str) {
+	COMMON_ALLOC_PROBE();
+
 	std::string s = str;
 	return common::to_upper(s);
 }
@@ -142,6 +167,8 @@ std::string common::to_upper(const std::string& str) {
 
 std::string common::to_hex(const unsigned char& number, size_t minimum_length) {
 
+	COMMON_ALLOC_PROBE();
+
 	char addressStr[4] = { 0 };
 	std::to_chars(std::begin(addressStr), std::end(addressStr), number, 16);
 	std::string ret{addressStr};
@@ -152,6 +179,8 @@ std::string common::to_hex(const unsigned char& number, size_t minimum_length) {
 
 std::string common::int_to_hex(const unsigned int& number) {
 
+	COMMON_ALLOC_PROBE();
+
 	char addressStr[20] = { 0 };
 	std::to_chars(std::begin(addressStr), std::end(addressStr), number, 16);
 	return std::string{addressStr};
@@ -187,10 +216,65 @@ double common::to_GiB(unsigned long int bytes) {
 	return (double)b * 0.1;
 }
 
+// Batch conversions compute the same operations as to_KiB/to_MiB/to_GiB,
+// but without branches or 64-bit int/double conversions so that the loop
+// vectorises: bytes below 2^52 are turned into double through the exponent
+// bias trick, (unsigned long)x is replaced by an exact truncation and the
+// threshold test masks the result bits. Larger values fall back to scalar.
+
+static inline double as_double(unsigned long int bits) {
+	return __builtin_bit_cast(double, bits);
+}
+
+static inline unsigned long int as_bits(double d) {
+	return __builtin_bit_cast(unsigned long int, d);
+}
+
+static void unit_division(const unsigned long int* bytes, double* out, size_t count,
+		unsigned long int threshold, double unit, double (*scalar)(unsigned long int)) {
+
+	const unsigned long int exponent = 0x4330000000000000UL; // 2^52
+	const double bias = 4503599627370496.0;
+	unsigned long int high = 0;
+
+	for ( size_t i = 0; i < count; i++ )
+		high |= bytes[i];
+
+	if ( high >> 52 ) {
+
+		for ( size_t i = 0; i < count; i++ )
+			out[i] = scalar(bytes[i]);
+		return;
+	}
+
+	for ( size_t i = 0; i < count; i++ ) {
+
+		double d = ( as_double(bytes[i] | exponent) - bias ) / unit;
+		double v = ( d * 10 ) + 0.5;
+		double b = ( v + bias ) - bias; // rounded to nearest, step back if rounded up
+		b -= as_double(-(unsigned long int)(as_bits(b) > as_bits(v)) & as_bits(1.0));
+		out[i] = as_double(as_bits(b * 0.1) & -(unsigned long int)( bytes[i] >= threshold ));
+	}
+}
+
+void common::to_KiB(const unsigned long int* bytes, double* out, size_t count) {
+	unit_division(bytes, out, count, 103, 1024, common::to_KiB);
+}
+
+void common::to_MiB(const unsigned long int* bytes, double* out, size_t count) {
+	unit_division(bytes, out, count, 104858, 1048576, common::to_MiB);
+}
+
+void common::to_GiB(const unsigned long int* bytes, double* out, size_t count) {
+	unit_division(bytes, out, count, 107374183, 1073741824, common::to_GiB);
+}
+
 // based on example found from https://en.cppreference.com/w/cpp/filesystem/file_size
 
 std::string common::HumanReadable(const double& d) {
 
+	COMMON_ALLOC_PROBE();
+
 	int o = 0;
 	double mantissa = d;
 	for ( ; mantissa >= 1024.; mantissa /= 1024., o++ );
@@ -200,6 +284,8 @@ std::string common::HumanReadable(const double& d) {
 
 std::string common::join_vector(const std::vector<std::string>& vec, const std::string& delim) {
 
+	COMMON_ALLOC_PROBE();
+
 		std::string res;
 
 		for ( auto s : vec )
@@ -210,6 +296,8 @@ std::string common::join_vector(const std::vector<std::string>& vec, const std::
 
 std::string common::join_vector(const std::vector<std::string>& vec, const common::char_type& delim) {
 
+	COMMON_ALLOC_PROBE();
+
 	return common::join_vector(vec, common::to_string(delim));
 }
 
@@ -278,6 +366,8 @@ bool common::starts_with_alnum(const std::string& s) {
 
 std::string common::erase_prefix(std::string& s, size_t n) {
 
+	COMMON_ALLOC_PROBE();
+
 	if ( s.empty() || n == 0 )
 		return "";
 
@@ -291,6 +381,8 @@ std::string common::erase_prefix(std::string& s, size_t n) {
 
 common::char_type common::erase_front(std::string &s) {
 
+	COMMON_ALLOC_PROBE();
+
 	if ( s.empty())
 		return 0;
 
@@ -301,6 +393,8 @@ common::char_type common::erase_front(std::string &s) {
 
 std::string common::to_string(const double& d) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::stringstream ss;
 	ss << std::fixed << d;
 	std::string s = ss.str();
@@ -317,6 +411,8 @@ std::string common::to_string(const double& d) {
 
 std::string common::unquoted(const std::string& s, bool trimmed) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::string r = trimmed ? trim_ws(s) : s;
 
 	if ( r.empty())
@@ -376,12 +472,16 @@ std::string common::unquoted(const std::string& s, bool trimmed) {
 
 std::string common::unquoted(std::string& s, bool trimmed) {
 
+	COMMON_ALLOC_PROBE();
+
 	s = unquoted(std::as_const(s));
 	return s;
 }
 
 std::string common::unquoted_and_trimmed(const std::string& s, bool lowercased) {
 
+	COMMON_ALLOC_PROBE();
+
 	return lowercased ?
 			common::to_lower(common::trim_ws(common::unquoted(common::trim_ws(std::as_const(s))))) :
 			common::trim_ws(common::unquoted(common::trim_ws(std::as_const(s))));
@@ -389,6 +489,8 @@ std::string common::unquoted_and_trimmed(const std::string& s, bool lowercased)
 
 std::string common::rtrim_ws(const std::string& s, const std::string& ws) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::string _s = s;
 	_s.erase(_s.find_last_not_of(ws) + 1);
 	return _s;
@@ -396,6 +498,8 @@ std::string common::rtrim_ws(const std::string& s, const std::string& ws) {
 
 std::string common::ltrim_ws(const std::string& s, const std::string& ws) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::string _s = s;
 	_s.erase(0, _s.find_first_not_of(ws));
 	return _s;
@@ -403,11 +507,15 @@ std::string common::ltrim_ws(const std::string& s, const std::string& ws) {
 
 std::string common::trim_ws(const std::string& s, const std::string& ws) {
 
+	COMMON_ALLOC_PROBE();
+
 	return common::ltrim_ws(common::rtrim_ws(s, ws), ws);
 }
 
 std::string common::trim_leading(const std::string& str, int count) {
 
+	COMMON_ALLOC_PROBE();
+
 	if ( count < 1 )
 		return str;
 
@@ -425,6 +533,8 @@ double common::round(double val) {
 
 std::string common::memToStr(double amount, bool gigabytes) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::ostringstream res;
 	double value = amount;
 	uint8_t valuetype = 0;
@@ -462,6 +572,8 @@ std::string common::memToStr(double amount, bool gigabytes) {
 
 std::string common::time_str(const std::time_t& t) {
 
+	COMMON_ALLOC_PROBE();
+
 /*
 	std::time_t _t = t;
 	struct tm *timeinfo = std::localtime(&_t);
@@ -477,6 +589,8 @@ std::string common::time_str(const std::time_t& t) {
 
 std::string common::uptime_str(const std::time_t& t, bool longdesc, bool seconds) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::time_t _t = t;
 	std::string ret;
 
@@ -532,8 +646,32 @@ std::chrono::milliseconds common::get_millis() {
 		(std::chrono::system_clock::now().time_since_epoch());
 }
 
+static common::metrics::counter parse_files("common_parsefile_files_total", "Files read by parseFile");
+static common::metrics::counter parse_errors("common_parsefile_errors_total", "Files parseFile failed to open");
+static common::metrics::counter parse_bytes("common_parsefile_bytes_total", "Bytes read by parseFile");
+static common::metrics::counter parse_lines("common_parsefile_lines_total", "Lines read by parseFile");
+
+static void parse_line(const std::string& s, const common::char_type& delim, tsl::ordered_map<std::string, std::string>& m) {
+
+	auto pos = s.find_first_of(delim);
+	if ( pos == std::string::npos )
+		return;
+
+	pos += 1;
+	std::string k = common::trim_ws(common::to_lower(s.substr(0, pos - 1)));
+	std::string v = common::trim_ws(s.substr(pos, sizeof(v) + 1 - pos));
+
+	if ( k.empty() || v.empty())
+		return;
+
+	m[k] = v;
+}
+
 common::lowercase_map<std::string> common::parseFile(const std::string& filename, const common::char_type& delim) {
 
+	COMMON_ALLOC_PROBE();
+	COMMON_TRACE_SCOPE("common::parseFile");
+
 	std::ifstream fd(filename, std::ios::in | std::ios::binary);
 	std::string s;
 	tsl::ordered_map<std::string, std::string> m;
@@ -543,26 +681,43 @@ common::lowercase_map<std::string> common::parseFile(const std::string& filename
 		if ( fd.is_open())
 			fd.close();
 
+		parse_errors++;
 		throw std::runtime_error("fatal error, could not read " + filename);
 	}
 
+	size_t lines = 0, bytes = 0;
+
 	while ( std::getline(fd, s)) {
+		parse_line(s, delim, m);
+		lines++;
+		bytes += s.size() + 1;
+	}
 
-		auto pos = s.find_first_of(delim);
-		if ( pos == std::string::npos )
-			continue;
+	fd.close();
 
-		pos += 1;
-		std::string k = common::trim_ws(common::to_lower(s.substr(0, pos - 1)));
-		std::string v = common::trim_ws(s.substr(pos, sizeof(v) + 1 - pos));
+	parse_files++;
+	parse_lines += lines;
+	parse_bytes += bytes;
 
-		if ( k.empty() || v.empty())
-			continue;
+	return m;
+}
+
+common::lowercase_map<std::string> common::parseBuffer(std::string_view data, const common::char_type& delim) {
 
-		m[k] = v;
+	COMMON_ALLOC_PROBE();
+	COMMON_TRACE_SCOPE("common::parseBuffer");
+
+	tsl::ordered_map<std::string, std::string> m;
+	std::string s;
+
+	while ( !data.empty()) {
+
+		size_t eol = data.find('\n');
+		s.assign(data.substr(0, eol));
+		parse_line(s, delim, m);
+		data.remove_prefix(eol == std::string_view::npos ? data.size() : eol + 1);
 	}
 
-	fd.close();
 	return m;
 }
 
@@ -598,6 +753,8 @@ std::chrono::seconds common::mk_duration(double d) {
 
 std::string common::put_time(const std::string& format, double d) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::stringstream ss;
 	std::chrono::seconds s = common::mk_duration(d);
 	std::chrono::system_clock::time_point tp(s);
@@ -609,6 +766,8 @@ std::string common::put_time(const std::string& format, double d) {
 
 std::string common::put_time(const std::string& format, const std::chrono::seconds &s) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::stringstream ss;
 	std::chrono::system_clock::time_point tp(s);
 	time_t t = std::chrono::system_clock::to_time_t(tp);
@@ -619,6 +778,8 @@ std::string common::put_time(const std::string& format, const std::chrono::secon
 
 std::string common::put_time(const std::string& format, const std::chrono::system_clock::time_point& tp) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::stringstream ss;
 	time_t t = std::chrono::system_clock::to_time_t(tp);
 
@@ -628,6 +789,8 @@ std::string common::put_time(const std::string& format, const std::chrono::syste
 
 std::string common::put_time(const std::string& format, const time_t& t) {
 
+	COMMON_ALLOC_PROBE();
+
 	std::stringstream ss;
 	ss << std::put_time(std::localtime(&t), format.c_str());
 	return ss.str();
@@ -642,6 +805,8 @@ struct tm common::to_tm(const std::chrono::time_point<std::chrono::system_clock>
 
 std::vector<gid_t> common::get_groups() {
 
+	COMMON_ALLOC_PROBE();
+
 	int n = ::getgroups(0, nullptr);
 	gid_t *gids = new gid_t[n];
 	::getgroups(n, gids);
@@ -650,8 +815,14 @@ std::vector<gid_t> common::get_groups() {
 	return groups;
 }
 
+static common::metrics::counter netdev_reads("common_netdevs_reads_total", "Reads of /proc/net/dev by get_netdevs");
+static common::metrics::gauge netdev_count("common_netdevs", "Network devices found by last get_netdevs");
+
 std::vector<std::string> common::get_netdevs() {
 
+	COMMON_ALLOC_PROBE();
+	COMMON_TRACE_SCOPE("common::get_netdevs");
+
 	if ( !std::filesystem::exists("/proc/net/dev"))
 		throw std::runtime_error("cannot access /proc/net/dev");
 
@@ -686,11 +857,17 @@ std::vector<std::string> common::get_netdevs() {
 	}
 
 	fd.close();
+
+	netdev_reads++;
+	netdev_count.set(devs.size());
+
 	return devs;
 }
 
 std::filesystem::path common::selfexe() {
 
+	COMMON_ALLOC_PROBE();
+
 	return std::filesystem::exists("/proc/self/exe") &&
 		std::filesystem::is_symlink("/proc/self/exe") ?
 			std::filesystem::read_symlink("/proc/self/exe") : "";
@@ -698,6 +875,8 @@ std::filesystem::path common::selfexe() {
 
 std::filesystem::path common::selfpath() {
 
+	COMMON_ALLOC_PROBE();
+
 	return std::filesystem::exists("/proc/self/exe") &&
 		std::filesystem::is_symlink("/proc/self/exe") ?
 			std::filesystem::read_symlink("/proc/self/exe").parent_path() : "";
@@ -705,6 +884,8 @@ std::filesystem::path common::selfpath() {
 
 std::filesystem::path common::selfbasename() {
 
+	COMMON_ALLOC_PROBE();
+
 	return std::filesystem::exists("/proc/self/exe") &&
 		std::filesystem::is_symlink("/proc/self/exe") ?
 			std::filesystem::read_symlink("/proc/self/exe").filename() : "";
@@ -0,0 +1,665 @@
+#include <string>
+#include <string_view>
+#include <cstring>
+#include <cstdint>
+#include <charconv>
+#include <variant>
+#include <stdexcept>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "common/json.hpp"
+#include "common/trace.hpp"
+
+namespace {
+
+	const size_t max_depth = 1024;
+
+	[[noreturn]] void fail(const std::string& msg, const char* begin, const char* at) {
+		throw std::runtime_error("json parse error, " + msg + " at offset " + std::to_string(at - begin));
+	}
+
+	inline const char* skip_ws(const char* p, const char* end) {
+
+		while ( p < end && ( *p == ' ' || *p == '\n' || *p == '\r' || *p == '\t' ))
+			p++;
+		return p;
+	}
+
+#if !defined(__SSE2__) && defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+	inline uint64_t swar_eq(uint64_t w, char ch) {
+
+		const uint64_t ones = 0x0101010101010101ULL;
+		uint64_t x = w ^ ( ones * (unsigned char)ch );
+		return ( x - ones ) & ~x & ( ones << 7 );
+	}
+#endif
+
+	// first '"' or '\\' in [p, end), 16 bytes at a time with SSE2,
+	// 8 bytes at a time on other little endian targets
+	inline const char* find_quote(const char* p, const char* end) {
+
+#if defined(__SSE2__)
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i escape = _mm_set1_epi8('\\');
+
+		for ( ; end - p >= 16; p += 16 ) {
+
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			int mask = _mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(c, quote), _mm_cmpeq_epi8(c, escape)));
+			if ( mask != 0 )
+				return p + __builtin_ctz(mask);
+		}
+#elif defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+		for ( ; end - p >= 8; p += 8 ) {
+
+			uint64_t w;
+			std::memcpy(&w, p, 8);
+			uint64_t mask = swar_eq(w, '"') | swar_eq(w, '\\');
+			if ( mask != 0 )
+				return p + ( __builtin_ctzll(mask) >> 3 );
+		}
+#endif
+		while ( p < end && *p != '"' && *p != '\\' )
+			p++;
+		return p;
+	}
+
+	// first of '"', '[', ']', '{', '}' in [p, end)
+	inline const char* find_structural(const char* p, const char* end) {
+
+#if defined(__SSE2__)
+		const __m128i quote = _mm_set1_epi8('"');
+		const __m128i open_square = _mm_set1_epi8('[');
+		const __m128i close_square = _mm_set1_epi8(']');
+		const __m128i open_curly = _mm_set1_epi8('{');
+		const __m128i close_curly = _mm_set1_epi8('}');
+
+		for ( ; end - p >= 16; p += 16 ) {
+
+			__m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+			__m128i m = _mm_or_si128(_mm_cmpeq_epi8(c, quote),
+					_mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(c, open_square), _mm_cmpeq_epi8(c, close_square)),
+						_mm_or_si128(_mm_cmpeq_epi8(c, open_curly), _mm_cmpeq_epi8(c, close_curly))));
+			int mask = _mm_movemask_epi8(m);
+			if ( mask != 0 )
+				return p + __builtin_ctz(mask);
+		}
+#endif
+		while ( p < end && *p != '"' && *p != '[' && *p != ']' && *p != '{' && *p != '}' )
+			p++;
+		return p;
+	}
+
+	inline int hex_value(char ch) {
+
+		if ( ch >= '0' && ch <= '9' ) return ch - '0';
+		if ( ch >= 'a' && ch <= 'f' ) return ch - 'a' + 10;
+		if ( ch >= 'A' && ch <= 'F' ) return ch - 'A' + 10;
+		return -1;
+	}
+
+	// decodes escaped string content starting after the opening quote,
+	// calls put for every output char and returns pointer to closing quote.
+	// Output never grows past input, so put may write into the input.
+	template<typename Put>
+	const char* unescape(const char* begin, const char* p, const char* end, Put put) {
+
+		while ( true ) {
+
+			const char* q = find_quote(p, end);
+
+			for ( ; p < q; p++ )
+				put(*p);
+
+			if ( q == end )
+				fail("unterminated string", begin, q);
+
+			if ( *q == '"' )
+				return q;
+
+			if ( ++p >= end )
+				fail("unterminated string", begin, p);
+
+			switch ( *p++ ) {
+				case '"': put('"'); break;
+				case '\\': put('\\'); break;
+				case '/': put('/'); break;
+				case 'b': put('\b'); break;
+				case 'f': put('\f'); break;
+				case 'n': put('\n'); break;
+				case 'r': put('\r'); break;
+				case 't': put('\t'); break;
+				case 'u': {
+
+					auto hex4 = [begin, end](const char* h) {
+						uint32_t cp = 0;
+						for ( int i = 0; i < 4; i++ ) {
+							int v = h + i < end ? hex_value(h[i]) : -1;
+							if ( v < 0 )
+								fail("invalid unicode escape", begin, h);
+							cp = ( cp << 4 ) | v;
+						}
+						return cp;
+					};
+
+					uint32_t cp = hex4(p);
+					p += 4;
+
+					if ( cp >= 0xd800 && cp <= 0xdbff && end - p >= 6 && p[0] == '\\' && p[1] == 'u' ) {
+
+						uint32_t lo = hex4(p + 2);
+						if ( lo >= 0xdc00 && lo <= 0xdfff ) {
+							cp = 0x10000 + (( cp - 0xd800 ) << 10 ) + ( lo - 0xdc00 );
+							p += 6;
+						}
+					}
+
+					if ( cp < 0x80 ) {
+						put((char)cp);
+					} else if ( cp < 0x800 ) {
+						put((char)( 0xc0 | ( cp >> 6 )));
+						put((char)( 0x80 | ( cp & 0x3f )));
+					} else if ( cp < 0x10000 ) {
+						put((char)( 0xe0 | ( cp >> 12 )));
+						put((char)( 0x80 | (( cp >> 6 ) & 0x3f )));
+						put((char)( 0x80 | ( cp & 0x3f )));
+					} else {
+						put((char)( 0xf0 | ( cp >> 18 )));
+						put((char)( 0x80 | (( cp >> 12 ) & 0x3f )));
+						put((char)( 0x80 | (( cp >> 6 ) & 0x3f )));
+						put((char)( 0x80 | ( cp & 0x3f )));
+					}
+					break;
+				}
+				default:
+					fail("invalid escape", begin, p - 1);
+			}
+		}
+	}
+
+	inline bool is_digit(char ch) {
+		return ch >= '0' && ch <= '9';
+	}
+
+	// end of number starting at p following JSON grammar,
+	// -?(0|[1-9][0-9]*)(.[0-9]+)?([eE][+-]?[0-9]+)? or nullptr. from_chars
+	// alone also takes inf, nan, leading zeros and hex float digits.
+	const char* number_end(const char* p, const char* end) {
+
+		if ( p < end && *p == '-' )
+			p++;
+
+		if ( p == end || !is_digit(*p))
+			return nullptr;
+
+		if ( *p++ != '0' )
+			while ( p < end && is_digit(*p))
+				p++;
+
+		if ( p < end && *p == '.' ) {
+
+			if ( ++p == end || !is_digit(*p))
+				return nullptr;
+
+			while ( p < end && is_digit(*p))
+				p++;
+		}
+
+		if ( p < end && ( *p == 'e' || *p == 'E' )) {
+
+			if ( ++p < end && ( *p == '+' || *p == '-' ))
+				p++;
+
+			if ( p == end || !is_digit(*p))
+				return nullptr;
+
+			while ( p < end && is_digit(*p))
+				p++;
+		}
+
+		return p;
+	}
+
+	// parses number in [p, q), q from number_end
+	bool to_number(const char* p, const char* q, double& d) {
+
+		auto [ptr, ec] = std::from_chars(p, q, d);
+		return ec == std::errc() && ptr == q;
+	}
+
+	bool literal(const char* p, const char* end, const char* word, size_t len) {
+		return (size_t)( end - p ) >= len && std::memcmp(p, word, len) == 0;
+	}
+
+	// Value is json::value or json::pmr::value, containers are created
+	// with alloc
+	template<typename Value>
+	class parser {
+
+		private:
+			using array = std::variant_alternative_t<4, typename Value::base_type>;
+			using object = std::variant_alternative_t<5, typename Value::base_type>;
+
+			const char* begin;
+			char* p;
+			char* end;
+			typename array::allocator_type alloc;
+
+			std::string_view string() {
+
+				char* start = ++this -> p;
+				const char* q = find_quote(start, this -> end);
+
+				if ( q < this -> end && *q == '"' ) {
+					this -> p = const_cast<char*>(q) + 1;
+					return std::string_view(start, q - start);
+				}
+
+				char* w = start;
+				q = unescape(this -> begin, start, this -> end, [&w](char ch) { *w++ = ch; });
+				this -> p = const_cast<char*>(q) + 1;
+				return std::string_view(start, w - start);
+			}
+
+			double number() {
+
+				double d;
+				const char* q = number_end(this -> p, this -> end);
+
+				if ( q == nullptr || !to_number(this -> p, q, d))
+					fail("invalid number", this -> begin, this -> p);
+
+				this -> p = const_cast<char*>(q);
+				return d;
+			}
+
+			char next() {
+
+				this -> p = const_cast<char*>(skip_ws(this -> p, this -> end));
+				if ( this -> p == this -> end )
+					fail("unexpected end of input", this -> begin, this -> p);
+				return *this -> p;
+			}
+
+		public:
+
+			parser(char* buf, size_t size, typename array::allocator_type alloc = {}) :
+				begin(buf), p(buf), end(buf + size), alloc(alloc) {}
+
+			Value value(size_t depth = 0) {
+
+				if ( depth > max_depth )
+					fail("nesting too deep", this -> begin, this -> p);
+
+				switch ( this -> next()) {
+
+					case '"':
+						return Value(this -> string());
+
+					case '[': {
+
+						array arr(this -> alloc);
+						this -> p++;
+
+						if ( this -> next() == ']' ) {
+							this -> p++;
+							return Value(std::move(arr));
+						}
+
+						while ( true ) {
+
+							arr.push_back(this -> value(depth + 1));
+
+							char ch = this -> next();
+							this -> p++;
+
+							if ( ch == ']' )
+								return Value(std::move(arr));
+							else if ( ch != ',' )
+								fail("expected ',' or ']'", this -> begin, this -> p - 1);
+						}
+					}
+
+					case '{': {
+
+						object obj(typename object::allocator_type(this -> alloc));
+						this -> p++;
+
+						if ( this -> next() == '}' ) {
+							this -> p++;
+							return Value(std::move(obj));
+						}
+
+						while ( true ) {
+
+							if ( this -> next() != '"' )
+								fail("expected string key", this -> begin, this -> p);
+
+							std::string_view key = this -> string();
+
+							if ( this -> next() != ':' )
+								fail("expected ':'", this -> begin, this -> p);
+
+							this -> p++;
+							obj.emplace_back(key, this -> value(depth + 1));
+
+							char ch = this -> next();
+							this -> p++;
+
+							if ( ch == '}' )
+								return Value(std::move(obj));
+							else if ( ch != ',' )
+								fail("expected ',' or '}'", this -> begin, this -> p - 1);
+						}
+					}
+
+					case 't':
+						if ( !literal(this -> p, this -> end, "true", 4))
+							fail("invalid literal", this -> begin, this -> p);
+						this -> p += 4;
+						return Value(true);
+
+					case 'f':
+						if ( !literal(this -> p, this -> end, "false", 5))
+							fail("invalid literal", this -> begin, this -> p);
+						this -> p += 5;
+						return Value(false);
+
+					case 'n':
+						if ( !literal(this -> p, this -> end, "null", 4))
+							fail("invalid literal", this -> begin, this -> p);
+						this -> p += 4;
+						return Value(nullptr);
+
+					default:
+						return Value(this -> number());
+				}
+			}
+
+			void finish() {
+
+				const char* q = skip_ws(this -> p, this -> end);
+				if ( q != this -> end )
+					fail("trailing characters", this -> begin, q);
+			}
+	};
+
+	// end of value starting at p
+	const char* skip_value(const char* begin, const char* p, const char* end) {
+
+		if ( p == end )
+			fail("unexpected end of input", begin, p);
+
+		if ( *p == '"' ) {
+
+			const char* q = p + 1;
+
+			while (( q = find_quote(q, end)) < end && *q == '\\' )
+				q += 2;
+
+			if ( q >= end )
+				fail("unterminated string", begin, p);
+
+			return q + 1;
+		}
+
+		if ( *p != '[' && *p != '{' ) {
+
+			while ( p < end && *p != ',' && *p != ']' && *p != '}' && *p != ' ' && *p != '\n' && *p != '\r' && *p != '\t' )
+				p++;
+			return p;
+		}
+
+		size_t depth = 0;
+
+		while (( p = find_structural(p, end)) < end ) {
+
+			if ( *p == '"' ) {
+				p = skip_value(begin, p, end);
+				continue;
+			}
+
+			if ( *p == '[' || *p == '{' )
+				depth++;
+			else if ( --depth == 0 )
+				return p + 1;
+			p++;
+		}
+
+		fail("unterminated container", begin, p);
+	}
+}
+
+common::json::value common::json::parse(char* buf, size_t size) {
+
+	COMMON_TRACE_SCOPE("common::json::parse");
+	parser<common::json::value> ps(buf, size);
+	common::json::value v = ps.value();
+	ps.finish();
+	return v;
+}
+
+common::json::value common::json::parse(std::string& buf) {
+
+	return common::json::parse(buf.data(), buf.size());
+}
+
+common::json::pmr::value common::json::parse(char* buf, size_t size, rva::arena& arena) {
+
+	COMMON_TRACE_SCOPE("common::json::parse");
+	parser<common::json::pmr::value> ps(buf, size, arena.allocator());
+	common::json::pmr::value v = ps.value();
+	ps.finish();
+	return v;
+}
+
+common::json::pmr::value common::json::parse(std::string& buf, rva::arena& arena) {
+
+	return common::json::parse(buf.data(), buf.size(), arena);
+}
+
+common::json::type common::json::type_of(const common::json::value& v) {
+
+	return static_cast<common::json::type>(v.index());
+}
+
+common::json::type common::json::type_of(const common::json::pmr::value& v) {
+
+	return static_cast<common::json::type>(v.index());
+}
+
+const common::json::value* common::json::find(const common::json::object& o, std::string_view key) {
+
+	for ( auto& [k, v] : o )
+		if ( k == key )
+			return &v;
+
+	return nullptr;
+}
+
+const common::json::pmr::value* common::json::find(const common::json::pmr::object& o, std::string_view key) {
+
+	for ( auto& [k, v] : o )
+		if ( k == key )
+			return &v;
+
+	return nullptr;
+}
+
+common::json::lazy::lazy(const char* data, size_t size) : p(skip_ws(data, data + size)), end(data + size) {}
+
+common::json::lazy::lazy(const std::string& buf) : lazy(buf.data(), buf.size()) {}
+
+const char* common::json::lazy::value_end() const {
+
+	return skip_value(this -> p, this -> p, this -> end);
+}
+
+common::json::type common::json::lazy::type() const {
+
+	if ( this -> p == this -> end )
+		fail("unexpected end of input", this -> p, this -> p);
+
+	switch ( *this -> p ) {
+		case '"': return common::json::type::string;
+		case '[': return common::json::type::array;
+		case '{': return common::json::type::object;
+		case 't':
+		case 'f': return common::json::type::boolean;
+		case 'n': return common::json::type::null;
+		default: return common::json::type::number;
+	}
+}
+
+bool common::json::lazy::is_null() const {
+
+	return literal(this -> p, this -> end, "null", 4);
+}
+
+bool common::json::lazy::boolean() const {
+
+	if ( literal(this -> p, this -> end, "true", 4))
+		return true;
+	else if ( literal(this -> p, this -> end, "false", 5))
+		return false;
+
+	fail("not a boolean", this -> p, this -> p);
+}
+
+double common::json::lazy::number() const {
+
+	double d;
+	const char* q = number_end(this -> p, this -> end);
+
+	if ( q == nullptr || q != this -> value_end() || !to_number(this -> p, q, d))
+		fail("not a number", this -> p, this -> p);
+
+	return d;
+}
+
+std::string common::json::lazy::string() const {
+
+	if ( this -> type() != common::json::type::string )
+		fail("not a string", this -> p, this -> p);
+
+	std::string s;
+	unescape(this -> p, this -> p + 1, this -> end, [&s](char ch) { s += ch; });
+	return s;
+}
+
+std::string_view common::json::lazy::raw() const {
+
+	return std::string_view(this -> p, this -> value_end() - this -> p);
+}
+
+size_t common::json::lazy::size() const {
+
+	common::json::type t = this -> type();
+
+	if ( t != common::json::type::array && t != common::json::type::object )
+		return 0;
+
+	const char* q = skip_ws(this -> p + 1, this -> end);
+	size_t n = 0;
+
+	while ( q < this -> end && *q != ']' && *q != '}' ) {
+
+		if ( t == common::json::type::object ) {
+			q = skip_ws(skip_value(this -> p, q, this -> end), this -> end);
+			q = q < this -> end && *q == ':' ? skip_ws(q + 1, this -> end) : q;
+		}
+
+		q = skip_ws(skip_value(this -> p, q, this -> end), this -> end);
+		n++;
+
+		if ( q < this -> end && *q == ',' )
+			q = skip_ws(q + 1, this -> end);
+	}
+
+	return n;
+}
+
+bool common::json::lazy::contains(std::string_view key) const {
+
+	if ( this -> type() != common::json::type::object )
+		return false;
+
+	const char* q = skip_ws(this -> p + 1, this -> end);
+
+	while ( q < this -> end && *q == '"' ) {
+
+		const char* k_end = skip_value(this -> p, q, this -> end);
+		std::string_view k(q + 1, k_end - q - 2);
+
+		if ( k.find('\\') != std::string_view::npos ? lazy(q, k_end, true).string() == key : k == key )
+			return true;
+
+		q = skip_ws(k_end, this -> end);
+		if ( q >= this -> end || *q != ':' )
+			fail("expected ':'", this -> p, q);
+
+		q = skip_ws(skip_value(this -> p, skip_ws(q + 1, this -> end), this -> end), this -> end);
+		if ( q < this -> end && *q == ',' )
+			q = skip_ws(q + 1, this -> end);
+	}
+
+	return false;
+}
+
+common::json::lazy common::json::lazy::operator [](std::string_view key) const {
+
+	if ( this -> type() != common::json::type::object )
+		fail("not an object", this -> p, this -> p);
+
+	const char* q = skip_ws(this -> p + 1, this -> end);
+
+	while ( q < this -> end && *q == '"' ) {
+
+		const char* k_end = skip_value(this -> p, q, this -> end);
+		std::string_view k(q + 1, k_end - q - 2);
+		bool match = k.find('\\') != std::string_view::npos ? lazy(q, k_end, true).string() == key : k == key;
+
+		q = skip_ws(k_end, this -> end);
+		if ( q >= this -> end || *q != ':' )
+			fail("expected ':'", this -> p, q);
+
+		q = skip_ws(q + 1, this -> end);
+		if ( match )
+			return lazy(q, this -> end, true);
+
+		q = skip_ws(skip_value(this -> p, q, this -> end), this -> end);
+		if ( q < this -> end && *q == ',' )
+			q = skip_ws(q + 1, this -> end);
+	}
+
+	throw std::runtime_error("json key " + std::string(key) + " not found");
+}
+
+common::json::lazy common::json::lazy::operator [](size_t index) const {
+
+	if ( this -> type() != common::json::type::array )
+		fail("not an array", this -> p, this -> p);
+
+	const char* q = skip_ws(this -> p + 1, this -> end);
+
+	for ( size_t i = 0; q < this -> end && *q != ']'; i++ ) {
+
+		if ( i == index )
+			return lazy(q, this -> end, true);
+
+		q = skip_ws(skip_value(this -> p, q, this -> end), this -> end);
+		if ( q < this -> end && *q == ',' )
+			q = skip_ws(q + 1, this -> end);
+	}
+
+	throw std::runtime_error("json index " + std::to_string(index) + " out of range");
+}
+
+common::json::value common::json::lazy::materialize(std::string& storage) const {
+
+	storage = this -> raw();
+	return common::json::parse(storage);
+}
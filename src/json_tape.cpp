@@ -0,0 +1,276 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <limits>
+#include <stdexcept>
+
+#include "common/json_tape.hpp"
+
+common::json::tape::tape(const common::json::value& v) {
+
+	this -> append(v);
+	this -> nodes.shrink_to_fit();
+	this -> pool.shrink_to_fit();
+}
+
+void common::json::tape::append_string(std::string_view s) {
+
+	if ( this -> pool.size() + s.size() > std::numeric_limits<uint32_t>::max())
+		throw std::runtime_error("json tape string pool is full");
+
+	node n;
+	n.type = common::json::type::string;
+	n.span = 1;
+	n.string = { (uint32_t)this -> pool.size(), (uint32_t)s.size() };
+	this -> nodes.push_back(n);
+	this -> pool.append(s);
+}
+
+void common::json::tape::append(const common::json::value& v) {
+
+	if ( this -> nodes.size() >= std::numeric_limits<uint32_t>::max())
+		throw std::runtime_error("json tape is full");
+
+	common::json::type t = common::json::type_of(v);
+
+	if ( t == common::json::type::string ) {
+		this -> append_string(std::get<std::string_view>(v));
+		return;
+	}
+
+	size_t idx = this -> nodes.size();
+	node n;
+	n.type = t;
+	n.span = 1;
+
+	switch ( t ) {
+
+		case common::json::type::boolean:
+			n.boolean = std::get<bool>(v);
+			this -> nodes.push_back(n);
+			return;
+
+		case common::json::type::number:
+			n.number = std::get<double>(v);
+			this -> nodes.push_back(n);
+			return;
+
+		case common::json::type::array: {
+
+			const common::json::array& arr = std::get<common::json::array>(v);
+			n.count = arr.size();
+			this -> nodes.push_back(n);
+
+			for ( const common::json::value& e : arr )
+				this -> append(e);
+			break;
+		}
+
+		case common::json::type::object: {
+
+			const common::json::object& obj = std::get<common::json::object>(v);
+			n.count = obj.size();
+			this -> nodes.push_back(n);
+
+			for ( const auto& [key, e] : obj ) {
+				this -> append_string(key);
+				this -> append(e);
+			}
+			break;
+		}
+
+		default:
+			n.count = 0;
+			this -> nodes.push_back(n);
+			return;
+	}
+
+	this -> nodes[idx].span = this -> nodes.size() - idx;
+}
+
+common::json::tape::ref common::json::tape::root() const {
+
+	if ( this -> nodes.empty())
+		throw std::runtime_error("json tape is empty");
+
+	return ref(this, 0);
+}
+
+size_t common::json::tape::memory_usage() const {
+
+	return this -> nodes.capacity() * sizeof(node) + this -> pool.capacity();
+}
+
+common::json::value common::json::tape::value_at(uint32_t& i) const {
+
+	const node& n = this -> nodes[i++];
+
+	switch ( n.type ) {
+
+		case common::json::type::boolean:
+			return common::json::value(n.boolean);
+
+		case common::json::type::number:
+			return common::json::value(n.number);
+
+		case common::json::type::string:
+			return common::json::value(std::string_view(this -> pool.data() + n.string.offset, n.string.length));
+
+		case common::json::type::array: {
+
+			common::json::array arr;
+			arr.reserve(n.count);
+
+			for ( uint32_t c = 0; c < n.count; c++ )
+				arr.push_back(this -> value_at(i));
+
+			return common::json::value(std::move(arr));
+		}
+
+		case common::json::type::object: {
+
+			common::json::object obj;
+			obj.reserve(n.count);
+
+			for ( uint32_t c = 0; c < n.count; c++ ) {
+				const node& k = this -> nodes[i++];
+				std::string_view key(this -> pool.data() + k.string.offset, k.string.length);
+				obj.emplace_back(key, this -> value_at(i));
+			}
+
+			return common::json::value(std::move(obj));
+		}
+
+		default:
+			return common::json::value(nullptr);
+	}
+}
+
+common::json::value common::json::tape::to_value() const {
+
+	uint32_t i = 0;
+	return this -> empty() ? common::json::value(nullptr) : this -> value_at(i);
+}
+
+bool common::json::tape::ref::boolean() const {
+
+	if ( this -> n().type != common::json::type::boolean )
+		throw std::runtime_error("json tape node is not a boolean");
+
+	return this -> n().boolean;
+}
+
+double common::json::tape::ref::number() const {
+
+	if ( this -> n().type != common::json::type::number )
+		throw std::runtime_error("json tape node is not a number");
+
+	return this -> n().number;
+}
+
+std::string_view common::json::tape::ref::string() const {
+
+	if ( this -> n().type != common::json::type::string )
+		throw std::runtime_error("json tape node is not a string");
+
+	return std::string_view(this -> t -> pool.data() + this -> n().string.offset, this -> n().string.length);
+}
+
+size_t common::json::tape::ref::size() const {
+
+	common::json::type t = this -> n().type;
+	return t == common::json::type::array || t == common::json::type::object ? this -> n().count : 0;
+}
+
+// node index of index'th child, for objects the index of member's key
+uint32_t common::json::tape::ref::child(size_t index) const {
+
+	if ( index >= this -> size())
+		throw std::runtime_error("json tape index " + std::to_string(index) + " out of range");
+
+	bool object = this -> n().type == common::json::type::object;
+	uint32_t c = this -> i + 1;
+
+	for ( size_t k = 0; k < index; k++ )
+		c += object ? 1 + this -> t -> nodes[c + 1].span : this -> t -> nodes[c].span;
+
+	return c;
+}
+
+std::string_view common::json::tape::ref::key(size_t index) const {
+
+	if ( this -> n().type != common::json::type::object )
+		throw std::runtime_error("json tape node is not an object");
+
+	return ref(this -> t, this -> child(index)).string();
+}
+
+common::json::tape::ref common::json::tape::ref::value(size_t index) const {
+
+	uint32_t c = this -> child(index);
+	return ref(this -> t, this -> n().type == common::json::type::object ? c + 1 : c);
+}
+
+bool common::json::tape::ref::contains(std::string_view key) const {
+
+	if ( this -> n().type != common::json::type::object )
+		return false;
+
+	uint32_t c = this -> i + 1;
+
+	for ( uint32_t k = 0; k < this -> n().count; k++ ) {
+
+		if ( ref(this -> t, c).string() == key )
+			return true;
+
+		c += 1 + this -> t -> nodes[c + 1].span;
+	}
+
+	return false;
+}
+
+common::json::tape::ref common::json::tape::ref::operator [](std::string_view key) const {
+
+	if ( this -> n().type != common::json::type::object )
+		throw std::runtime_error("json tape node is not an object");
+
+	uint32_t c = this -> i + 1;
+
+	for ( uint32_t k = 0; k < this -> n().count; k++ ) {
+
+		if ( ref(this -> t, c).string() == key )
+			return ref(this -> t, c + 1);
+
+		c += 1 + this -> t -> nodes[c + 1].span;
+	}
+
+	throw std::runtime_error("json key " + std::string(key) + " not found");
+}
+
+common::json::tape::ref common::json::tape::ref::operator [](size_t index) const {
+
+	if ( this -> n().type != common::json::type::array )
+		throw std::runtime_error("json tape node is not an array");
+
+	return ref(this -> t, this -> child(index));
+}
+
+common::json::tape::iterator common::json::tape::ref::begin() const {
+
+	return iterator(this -> t, this -> size() == 0 ? this -> i + this -> n().span : this -> i + 1, this -> n().type == common::json::type::object);
+}
+
+common::json::tape::iterator common::json::tape::ref::end() const {
+
+	return iterator(this -> t, this -> i + this -> n().span, this -> n().type == common::json::type::object);
+}
+
+common::json::tape::ref common::json::tape::iterator::operator *() const {
+
+	return ref(this -> t, this -> object ? this -> i + 1 : this -> i);
+}
+
+std::string_view common::json::tape::iterator::key() const {
+
+	return this -> object ? ref(this -> t, this -> i).string() : std::string_view();
+}
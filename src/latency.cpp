@@ -0,0 +1,256 @@
+#include <ostream>
+#include <iomanip>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <string_view>
+
+#include "common/latency.hpp"
+
+namespace {
+
+	// histogram of one thread and site, written only by its thread
+	struct cell {
+
+		std::atomic<uint64_t> counts[common::latency::bucket_count] = {};
+		std::atomic<uint64_t> count{0};
+		std::atomic<uint64_t> sum{0};
+		std::atomic<uint64_t> min{UINT64_MAX};
+		std::atomic<uint64_t> max{0};
+
+		// single writer, plain load + store is enough
+		static void bump(std::atomic<uint64_t>& a, uint64_t v) {
+			a.store(a.load(std::memory_order_relaxed) + v, std::memory_order_relaxed);
+		}
+
+		void add(uint64_t ns) {
+
+			cell::bump(this -> counts[common::latency::bucket(ns)], 1);
+			cell::bump(this -> count, 1);
+			cell::bump(this -> sum, ns);
+
+			if ( ns < this -> min.load(std::memory_order_relaxed))
+				this -> min.store(ns, std::memory_order_relaxed);
+			if ( ns > this -> max.load(std::memory_order_relaxed))
+				this -> max.store(ns, std::memory_order_relaxed);
+		}
+
+		void read_into(common::latency::histogram& h) const {
+
+			common::latency::histogram t;
+
+			for ( size_t i = 0; i < common::latency::bucket_count; i++ )
+				t.counts[i] = this -> counts[i].load(std::memory_order_relaxed);
+
+			t.count = this -> count.load(std::memory_order_relaxed);
+			t.sum = this -> sum.load(std::memory_order_relaxed);
+			t.min = this -> min.load(std::memory_order_relaxed);
+			t.max = this -> max.load(std::memory_order_relaxed);
+
+			if ( t.count != 0 )
+				h.merge(t);
+		}
+
+		void clear() {
+
+			for ( auto& c : this -> counts )
+				c.store(0, std::memory_order_relaxed);
+
+			this -> count.store(0, std::memory_order_relaxed);
+			this -> sum.store(0, std::memory_order_relaxed);
+			this -> min.store(UINT64_MAX, std::memory_order_relaxed);
+			this -> max.store(0, std::memory_order_relaxed);
+		}
+	};
+}
+
+namespace common::latency {
+
+	// owns every cell, so histograms outlive threads that wrote them. Cells
+	// of an exited thread are handed to the next thread recording at the
+	// same site, so there are only as many as threads alive at once.
+	struct registry {
+
+		std::mutex lock;
+		std::vector<site*> sites;
+		std::vector<std::vector<std::unique_ptr<cell>>> cells; // per site id
+		std::vector<std::vector<cell*>> unused; // per site id
+
+		static registry& get() {
+			static registry* r = new registry; // never destroyed, probes may run during exit
+			return *r;
+		}
+
+		size_t add(site* s) {
+			std::lock_guard<std::mutex> guard(this -> lock);
+			this -> sites.push_back(s);
+			this -> cells.emplace_back();
+			this -> unused.emplace_back();
+			return this -> sites.size() - 1;
+		}
+
+		cell* create(size_t id) {
+
+			std::lock_guard<std::mutex> guard(this -> lock);
+
+			if ( !this -> unused[id].empty()) {
+				cell* c = this -> unused[id].back();
+				this -> unused[id].pop_back();
+				return c;
+			}
+
+			this -> cells[id].push_back(std::make_unique<cell>());
+			return this -> cells[id].back().get();
+		}
+
+		void release(const std::vector<cell*>& by_site) {
+
+			std::lock_guard<std::mutex> guard(this -> lock);
+
+			for ( size_t id = 0; id < by_site.size(); id++ )
+				if ( by_site[id] != nullptr )
+					this -> unused[id].push_back(by_site[id]);
+		}
+	};
+}
+
+// cells of calling thread by site id, returned to registry on thread exit
+static thread_local struct thread_cells {
+
+	std::vector<cell*> by_site;
+
+	~thread_cells() {
+		common::latency::registry::get().release(this -> by_site);
+		this -> by_site.clear();
+	}
+} local_cells;
+
+common::latency::site::site(const char* name) : name(name) {
+
+	this -> id = common::latency::registry::get().add(this);
+}
+
+void common::latency::site::record(uint64_t ns) {
+
+	std::vector<cell*>& cells = local_cells.by_site;
+
+	if ( this -> id >= cells.size())
+		cells.resize(this -> id + 1, nullptr);
+
+	cell*& c = cells[this -> id];
+
+	if ( c == nullptr )
+		c = common::latency::registry::get().create(this -> id);
+
+	c -> add(ns);
+}
+
+void common::latency::histogram::record(uint64_t ns) {
+
+	this -> counts[common::latency::bucket(ns)]++;
+	this -> min = this -> count == 0 ? ns : std::min(this -> min, ns);
+	this -> max = std::max(this -> max, ns);
+	this -> count++;
+	this -> sum += ns;
+}
+
+void common::latency::histogram::merge(const common::latency::histogram& other) {
+
+	if ( other.count == 0 )
+		return;
+
+	for ( size_t i = 0; i < common::latency::bucket_count; i++ )
+		this -> counts[i] += other.counts[i];
+
+	this -> min = this -> count == 0 ? other.min : std::min(this -> min, other.min);
+	this -> max = std::max(this -> max, other.max);
+	this -> count += other.count;
+	this -> sum += other.sum;
+}
+
+uint64_t common::latency::histogram::percentile(double p) const {
+
+	if ( this -> count == 0 )
+		return 0;
+
+	uint64_t rank = (uint64_t)( std::clamp(p, 0.0, 100.0) / 100.0 * this -> count + 0.5 );
+	uint64_t seen = 0;
+
+	for ( size_t i = 0; i < common::latency::bucket_count; i++ ) {
+
+		seen += this -> counts[i];
+
+		if ( seen >= rank && seen != 0 )
+			return std::clamp(common::latency::bucket_max(i), this -> min, this -> max);
+	}
+
+	return this -> max;
+}
+
+common::latency::histogram common::latency::read(std::string_view name) {
+
+	common::latency::registry& r = common::latency::registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+	common::latency::histogram h;
+
+	for ( size_t id = 0; id < r.sites.size(); id++ )
+		if ( std::string_view(r.sites[id] -> label()) == name )
+			for ( const auto& c : r.cells[id] )
+				c -> read_into(h);
+
+	return h;
+}
+
+std::vector<common::latency::result> common::latency::report() {
+
+	common::latency::registry& r = common::latency::registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+	std::vector<common::latency::result> v;
+
+	for ( size_t id = 0; id < r.sites.size(); id++ ) {
+
+		// probes with same name in different places are reported together
+		auto it = std::find_if(v.begin(), v.end(), [&](const common::latency::result& res) {
+			return std::string_view(res.name) == r.sites[id] -> label();
+		});
+
+		if ( it == v.end())
+			it = v.insert(v.end(), { r.sites[id] -> label(), {}});
+
+		for ( const auto& c : r.cells[id] )
+			c -> read_into(it -> hist);
+	}
+
+	return v;
+}
+
+void common::latency::dump(std::ostream& os) {
+
+	os << std::left << std::setw(32) << "probe" << std::right << std::setw(12) << "count" <<
+		std::setw(12) << "mean" << std::setw(10) << "p50" << std::setw(10) << "p90" <<
+		std::setw(10) << "p99" << std::setw(10) << "p99.9" << std::setw(12) << "max" << "  (ns)" << std::endl;
+
+	for ( const common::latency::result& res : common::latency::report()) {
+
+		if ( res.hist.count == 0 )
+			continue;
+
+		os << std::left << std::setw(32) << res.name << std::right << std::setw(12) << res.hist.count <<
+			std::setw(12) << std::fixed << std::setprecision(0) << res.hist.mean() <<
+			std::setw(10) << res.hist.percentile(50) << std::setw(10) << res.hist.percentile(90) <<
+			std::setw(10) << res.hist.percentile(99) << std::setw(10) << res.hist.percentile(99.9) <<
+			std::setw(12) << res.hist.max << std::endl;
+	}
+}
+
+void common::latency::reset() {
+
+	common::latency::registry& r = common::latency::registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+
+	for ( auto& site_cells : r.cells )
+		for ( auto& c : site_cells )
+			c -> clear();
+}
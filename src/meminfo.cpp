@@ -0,0 +1,157 @@
+#include <string>
+#include <string_view>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "common/field_table.hpp"
+#include "common/meminfo.hpp"
+#include "common/trace.hpp"
+
+namespace {
+
+	using meminfo_table = common::field_table<common::meminfo, 35>;
+	using status_table = common::field_table<common::proc_status, 21>;
+
+	constexpr meminfo_table meminfo_fields({{
+		{ "MemTotal", &common::meminfo::total },
+		{ "MemFree", &common::meminfo::free },
+		{ "MemAvailable", &common::meminfo::available },
+		{ "Buffers", &common::meminfo::buffers },
+		{ "Cached", &common::meminfo::cached },
+		{ "SwapCached", &common::meminfo::swap_cached },
+		{ "Active", &common::meminfo::active },
+		{ "Inactive", &common::meminfo::inactive },
+		{ "Active(anon)", &common::meminfo::active_anon },
+		{ "Inactive(anon)", &common::meminfo::inactive_anon },
+		{ "Active(file)", &common::meminfo::active_file },
+		{ "Inactive(file)", &common::meminfo::inactive_file },
+		{ "Unevictable", &common::meminfo::unevictable },
+		{ "Mlocked", &common::meminfo::mlocked },
+		{ "SwapTotal", &common::meminfo::swap_total },
+		{ "SwapFree", &common::meminfo::swap_free },
+		{ "Dirty", &common::meminfo::dirty },
+		{ "Writeback", &common::meminfo::writeback },
+		{ "AnonPages", &common::meminfo::anon_pages },
+		{ "Mapped", &common::meminfo::mapped },
+		{ "Shmem", &common::meminfo::shmem },
+		{ "KReclaimable", &common::meminfo::kreclaimable },
+		{ "Slab", &common::meminfo::slab },
+		{ "SReclaimable", &common::meminfo::sreclaimable },
+		{ "SUnreclaim", &common::meminfo::sunreclaim },
+		{ "KernelStack", &common::meminfo::kernel_stack },
+		{ "PageTables", &common::meminfo::page_tables },
+		{ "CommitLimit", &common::meminfo::commit_limit },
+		{ "Committed_AS", &common::meminfo::committed_as },
+		{ "VmallocTotal", &common::meminfo::vmalloc_total },
+		{ "VmallocUsed", &common::meminfo::vmalloc_used },
+		{ "AnonHugePages", &common::meminfo::anon_huge_pages },
+		{ "HugePages_Total", &common::meminfo::huge_pages_total },
+		{ "HugePages_Free", &common::meminfo::huge_pages_free },
+		{ "Hugepagesize", &common::meminfo::hugepagesize }
+	}});
+
+	constexpr status_table status_fields({{
+		{ "Pid", &common::proc_status::pid },
+		{ "PPid", &common::proc_status::ppid },
+		{ "Uid", &common::proc_status::uid },
+		{ "Gid", &common::proc_status::gid },
+		{ "Threads", &common::proc_status::threads },
+		{ "VmPeak", &common::proc_status::vm_peak },
+		{ "VmSize", &common::proc_status::vm_size },
+		{ "VmLck", &common::proc_status::vm_lck },
+		{ "VmHWM", &common::proc_status::vm_hwm },
+		{ "VmRSS", &common::proc_status::vm_rss },
+		{ "RssAnon", &common::proc_status::rss_anon },
+		{ "RssFile", &common::proc_status::rss_file },
+		{ "RssShmem", &common::proc_status::rss_shmem },
+		{ "VmData", &common::proc_status::vm_data },
+		{ "VmStk", &common::proc_status::vm_stk },
+		{ "VmExe", &common::proc_status::vm_exe },
+		{ "VmLib", &common::proc_status::vm_lib },
+		{ "VmPTE", &common::proc_status::vm_pte },
+		{ "VmSwap", &common::proc_status::vm_swap },
+		{ "voluntary_ctxt_switches", &common::proc_status::voluntary_ctxt_switches },
+		{ "nonvoluntary_ctxt_switches", &common::proc_status::nonvoluntary_ctxt_switches }
+	}});
+
+	static_assert(meminfo_fields.find("MemAvailable") != nullptr && meminfo_fields.find("MemUsed") == nullptr);
+	static_assert(status_fields.find("VmRSS") != nullptr && status_fields.find("Name") == nullptr);
+
+	// both files are a few kB, read into caller's stack buffer. A file
+	// that fills it is read to the end into more instead.
+	template<size_t Size>
+	std::string_view read_small(const char* path, char (&buf)[Size], std::string& more) {
+
+		int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+		if ( fd < 0 )
+			return std::string_view();
+
+		size_t len = 0;
+		ssize_t r;
+
+		while ( len < Size && ( r = ::read(fd, buf + len, Size - len)) > 0 )
+			len += r;
+
+		if ( len < Size ) {
+			::close(fd);
+			return std::string_view(buf, len);
+		}
+
+		more.assign(buf, len);
+
+		do {
+			more.resize(len + Size);
+			r = ::read(fd, more.data() + len, Size);
+			len += r > 0 ? r : 0;
+		} while ( r > 0 );
+
+		::close(fd);
+		more.resize(len);
+		return more;
+	}
+}
+
+size_t common::meminfo::decode(std::string_view data) {
+
+	return meminfo_fields.decode(data, *this);
+}
+
+bool common::meminfo::read(const char* path) {
+
+	COMMON_TRACE_SCOPE("common::meminfo::read");
+	char buf[8192];
+	std::string more;
+	return this -> decode(read_small(path, buf, more)) != 0;
+}
+
+unsigned long common::meminfo::used() const {
+
+	unsigned long total = this -> total.raw();
+
+	if ( this -> available.raw() != 0 )
+		return total - this -> available.raw();
+
+	unsigned long unused = this -> free.raw() + this -> buffers.raw() + this -> cached.raw();
+	return total > unused ? total - unused : 0;
+}
+
+size_t common::proc_status::decode(std::string_view data) {
+
+	return status_fields.decode(data, *this);
+}
+
+bool common::proc_status::read(pid_t pid) {
+
+	char path[32];
+	std::snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+	return this -> read(path);
+}
+
+bool common::proc_status::read(const char* path) {
+
+	COMMON_TRACE_SCOPE("common::proc_status::read");
+	char buf[8192];
+	std::string more;
+	return this -> decode(read_small(path, buf, more)) != 0;
+}
@@ -0,0 +1,175 @@
+#include <ostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+
+#include "common/metrics.hpp"
+
+namespace {
+
+	const size_t chunk_size = 64;
+
+	// counter cells of one thread, chunks do not share cache lines with
+	// other threads' chunks; written only by the owning thread
+	struct alignas(64) chunk {
+		std::atomic<uint64_t> cells[chunk_size] = {};
+	};
+
+	struct thread_cells {
+		std::vector<std::unique_ptr<chunk>> chunks;
+	};
+
+	struct entry {
+		const char* name;
+		const char* help;
+		common::metrics::kind kind;
+		size_t id; // counter cell
+		const common::metrics::gauge* g;
+	};
+
+	// owns every thread's cells, so counts of exited threads stay. Cells of
+	// an exited thread are handed to the next new thread, which keeps
+	// adding to them, so there are only as many as threads alive at once.
+	struct registry {
+
+		std::mutex lock;
+		std::vector<entry> entries;
+		std::vector<std::unique_ptr<thread_cells>> threads;
+		std::vector<thread_cells*> unused;
+		size_t counters = 0;
+
+		static registry& get() {
+			static registry* r = new registry; // never destroyed, counters may be bumped during exit
+			return *r;
+		}
+
+		uint64_t sum(size_t id) {
+
+			uint64_t n = 0;
+
+			for ( const auto& t : this -> threads )
+				if ( id / chunk_size < t -> chunks.size() && t -> chunks[id / chunk_size] )
+					n += t -> chunks[id / chunk_size] -> cells[id % chunk_size].load(std::memory_order_relaxed);
+
+			return n;
+		}
+
+		int64_t value(const entry& e) {
+			return e.kind == common::metrics::kind::counter ? (int64_t)this -> sum(e.id) : e.g -> value();
+		}
+	};
+}
+
+static thread_local thread_cells* local_cells = nullptr;
+
+// returns cells of thread to registry when thread exits
+static thread_local struct cells_release {
+
+	~cells_release() {
+
+		if ( local_cells == nullptr )
+			return;
+
+		registry& r = registry::get();
+		std::lock_guard<std::mutex> guard(r.lock);
+		r.unused.push_back(local_cells);
+		local_cells = nullptr;
+	}
+} local_release;
+
+static std::atomic<uint64_t>& cell(size_t id) {
+
+	size_t c = id / chunk_size;
+
+	if ( local_cells == nullptr || c >= local_cells -> chunks.size() || !local_cells -> chunks[c] ) {
+
+		registry& r = registry::get();
+		std::lock_guard<std::mutex> guard(r.lock);
+
+		if ( local_cells == nullptr && !r.unused.empty()) {
+			local_cells = r.unused.back();
+			r.unused.pop_back();
+		} else if ( local_cells == nullptr ) {
+			r.threads.push_back(std::make_unique<thread_cells>());
+			local_cells = r.threads.back().get();
+		}
+
+		// registers release on thread exit
+		(void)&local_release;
+
+		if ( c >= local_cells -> chunks.size())
+			local_cells -> chunks.resize(c + 1);
+
+		if ( !local_cells -> chunks[c] )
+			local_cells -> chunks[c] = std::make_unique<chunk>();
+	}
+
+	return local_cells -> chunks[c] -> cells[id % chunk_size];
+}
+
+common::metrics::counter::counter(const char* name, const char* help) {
+
+	registry& r = registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+
+	this -> id = r.counters++;
+	r.entries.push_back({ name, help, common::metrics::kind::counter, this -> id, nullptr });
+}
+
+void common::metrics::counter::add(uint64_t n) {
+
+	// single writer, plain load + store is enough
+	std::atomic<uint64_t>& c = cell(this -> id);
+	c.store(c.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+}
+
+uint64_t common::metrics::counter::value() const {
+
+	registry& r = registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+	return r.sum(this -> id);
+}
+
+common::metrics::gauge::gauge(const char* name, const char* help) {
+
+	registry& r = registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+	r.entries.push_back({ name, help, common::metrics::kind::gauge, 0, this });
+}
+
+std::vector<common::metrics::sample> common::metrics::report() {
+
+	registry& r = registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+	std::vector<common::metrics::sample> v;
+
+	for ( const entry& e : r.entries )
+		v.push_back({ e.name, e.help, e.kind, r.value(e) });
+
+	return v;
+}
+
+int64_t common::metrics::read(std::string_view name) {
+
+	registry& r = registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+
+	for ( const entry& e : r.entries )
+		if ( name == e.name )
+			return r.value(e);
+
+	return 0;
+}
+
+void common::metrics::dump(std::ostream& os) {
+
+	for ( const common::metrics::sample& s : common::metrics::report()) {
+
+		os << "# HELP " << s.name << " " << s.help << "\n" <<
+			"# TYPE " << s.name << ( s.kind == common::metrics::kind::counter ? " counter" : " gauge" ) << "\n" <<
+			s.name << " " << s.value << "\n";
+	}
+
+	os.flush();
+}
@@ -0,0 +1,148 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstring>
+
+#include "common/parallel_split.hpp"
+#include "common/alloc_probe.hpp"
+#include "common/trace.hpp"
+
+// chunks of data, all but last one end right after a delimiter
+static std::vector<std::string_view> cut(std::string_view data, const common::char_type& delim, size_t chunk_size) {
+
+	std::vector<std::string_view> chunks;
+	size_t pos = 0;
+
+	if ( chunk_size == 0 )
+		chunk_size = 1;
+
+	while ( pos < data.size()) {
+
+		size_t end = pos + chunk_size;
+
+		if ( end >= data.size())
+			end = data.size();
+		else if ( const void* p = std::memchr(data.data() + end - 1, delim, data.size() - end + 1))
+			end = static_cast<const char*>(p) - data.data() + 1;
+		else end = data.size();
+
+		chunks.push_back(data.substr(pos, end - pos));
+		pos = end;
+	}
+
+	return chunks;
+}
+
+// make(token, out) appends what token becomes, if anything
+template <typename T, typename Make>
+static std::vector<T> tokenize(std::string_view data, const common::char_type& delim,
+		common::thread_pool& pool, size_t chunk_size, Make make) {
+
+	std::vector<std::string_view> chunks = cut(data, delim, chunk_size);
+
+	std::vector<std::vector<T>> parts = pool.parallel_transform(chunks, [&delim, &make](std::string_view chunk) {
+
+		std::vector<T> v;
+		const char* p = chunk.data();
+		const char* end = chunk.data() + chunk.size();
+
+		// text after last delimiter is left out, like lines() does
+		while ( const void* d = std::memchr(p, delim, end - p)) {
+			make(std::string_view(p, static_cast<const char*>(d) - p), v);
+			p = static_cast<const char*>(d) + 1;
+		}
+
+		return v;
+	}, 1);
+
+	std::vector<size_t> offsets(parts.size() + 1, 0);
+
+	for ( size_t i = 0; i < parts.size(); i++ )
+		offsets[i + 1] = offsets[i] + parts[i].size();
+
+	std::vector<T> out(offsets.back());
+
+	pool.parallel_for((size_t)0, parts.size(), [&](size_t i) {
+		std::move(parts[i].begin(), parts[i].end(), out.begin() + offsets[i]);
+	}, 1);
+
+	return out;
+}
+
+static std::vector<std::string> tokenize_strings(const std::string& str, const common::char_type& delim,
+		const std::string& trimchars, bool skip_empty, common::thread_pool& pool, size_t chunk_size) {
+
+	// sequential version removes trimchars first, delimiters included
+	if ( trimchars.find(delim) != std::string::npos )
+		return {};
+
+	return tokenize<std::string>(str, delim, pool, chunk_size,
+		[&trimchars, skip_empty](std::string_view tok, std::vector<std::string>& v) {
+
+		std::string s;
+
+		if ( trimchars.empty() || tok.find_first_of(trimchars) == std::string_view::npos )
+			s.assign(tok);
+		else
+			for ( char c : tok )
+				if ( trimchars.find(c) == std::string::npos )
+					s += c;
+
+		if ( !skip_empty || !s.empty())
+			v.push_back(std::move(s));
+	});
+}
+
+std::vector<std::string_view> common::parallel_tokenize(std::string_view data, const common::char_type& delim,
+		bool skip_empty, common::thread_pool& pool, size_t chunk_size) {
+
+	COMMON_ALLOC_PROBE();
+	COMMON_TRACE_SCOPE("common::parallel_tokenize");
+
+	return tokenize<std::string_view>(data, delim, pool, chunk_size,
+		[skip_empty](std::string_view tok, std::vector<std::string_view>& v) {
+
+		if ( !skip_empty || !tok.empty())
+			v.push_back(tok);
+	});
+}
+
+std::vector<std::string> common::parallel_lines(const std::string& str, const common::char_type& delim,
+		const std::string& trimchars, common::thread_pool& pool, size_t chunk_size) {
+
+	COMMON_ALLOC_PROBE();
+	COMMON_TRACE_SCOPE("common::parallel_lines");
+
+	return tokenize_strings(str, delim, trimchars, false, pool, chunk_size);
+}
+
+std::vector<std::string> common::parallel_lines(const std::string& str, const std::string& delim,
+		const std::string& trimchars, common::thread_pool& pool, size_t chunk_size) {
+
+	COMMON_ALLOC_PROBE();
+
+	if ( delim.size() != 1 )
+		return common::lines(str, delim, trimchars);
+
+	return common::parallel_lines(str, delim[0], trimchars, pool, chunk_size);
+}
+
+std::vector<std::string> common::parallel_split(const std::string& str, const common::char_type& delim,
+		const std::string& trimchars, common::thread_pool& pool, size_t chunk_size) {
+
+	COMMON_ALLOC_PROBE();
+	COMMON_TRACE_SCOPE("common::parallel_split");
+
+	return tokenize_strings(str, delim, trimchars, true, pool, chunk_size);
+}
+
+std::vector<std::string> common::parallel_split(const std::string& str, const std::string& delim,
+		const std::string& trimchars, common::thread_pool& pool, size_t chunk_size) {
+
+	COMMON_ALLOC_PROBE();
+
+	if ( delim.size() != 1 )
+		return common::split(str, delim, trimchars);
+
+	return common::parallel_split(str, delim[0], trimchars, pool, chunk_size);
+}
@@ -0,0 +1,312 @@
+#include <string>
+#include <string_view>
+#include <vector>
+#include <charconv>
+#include <stdexcept>
+#include <cstring>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+
+#include "common/proctable.hpp"
+#include "common/trace.hpp"
+
+namespace {
+
+	// getdents64 record, glibc does not declare it
+	struct linux_dirent64 {
+		ino64_t d_ino;
+		off64_t d_off;
+		unsigned short d_reclen;
+		unsigned char d_type;
+		char d_name[];
+	};
+
+	const size_t dents_size = 256 * 1024;
+
+	inline bool next_field(const char*& p, const char* end, long long& value) {
+
+		while ( p < end && *p == ' ' )
+			p++;
+
+		auto [ptr, ec] = std::from_chars(p, end, value);
+		if ( ec != std::errc())
+			return false;
+
+		p = ptr;
+		return true;
+	}
+}
+
+std::string_view common::proc_table::snapshot::name(size_t i) const {
+
+	return std::string_view(this -> names.data() + this -> name_offset[i], this -> name_length[i]);
+}
+
+double common::proc_table::snapshot::cpu_percent(size_t i) const {
+
+	if ( this -> interval.count() <= 0 )
+		return 0;
+
+	double seconds = std::chrono::duration<double>(this -> interval).count();
+	return (double)this -> cpu_delta[i] / this -> ticks_per_second / seconds * 100.0;
+}
+
+void common::proc_table::snapshot::clear() {
+
+	this -> pid.clear();
+	this -> ppid.clear();
+	this -> state.clear();
+	this -> utime.clear();
+	this -> stime.clear();
+	this -> rss.clear();
+	this -> threads.clear();
+	this -> starttime.clear();
+	this -> cpu_delta.clear();
+	this -> names.clear();
+	this -> name_offset.clear();
+	this -> name_length.clear();
+}
+
+void common::proc_table::snapshot::reserve(size_t n) {
+
+	this -> pid.reserve(n);
+	this -> ppid.reserve(n);
+	this -> state.reserve(n);
+	this -> utime.reserve(n);
+	this -> stime.reserve(n);
+	this -> rss.reserve(n);
+	this -> threads.reserve(n);
+	this -> starttime.reserve(n);
+	this -> cpu_delta.reserve(n);
+	this -> names.reserve(n * 16);
+	this -> name_offset.reserve(n);
+	this -> name_length.reserve(n);
+}
+
+common::proc_table::proc_table(const std::string& proc, size_t max_open) : fd_budget(max_open), dents(dents_size), buf(1024) {
+
+	this -> dir_fd = ::open(proc.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+
+	if ( this -> dir_fd < 0 )
+		throw std::runtime_error("failed to open " + proc + ": " + std::strerror(errno));
+
+	// rest of descriptor table belongs to the application
+	struct rlimit rl;
+	if ( ::getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur != RLIM_INFINITY && rl.rlim_cur / 4 < this -> fd_budget )
+		this -> fd_budget = rl.rlim_cur / 4;
+
+	this -> page_size = ::sysconf(_SC_PAGESIZE);
+	this -> snap.ticks_per_second = ::sysconf(_SC_CLK_TCK);
+}
+
+common::proc_table::~proc_table() {
+
+	for ( auto& [pid, e] : this -> entries )
+		if ( e.fd >= 0 )
+			::close(e.fd);
+
+	if ( this -> dir_fd >= 0 )
+		::close(this -> dir_fd);
+}
+
+size_t common::proc_table::open_files() const {
+
+	return this -> persistent;
+}
+
+void common::proc_table::close_entry(common::proc_table::entry& e) {
+
+	if ( e.fd < 0 )
+		return;
+
+	::close(e.fd);
+	e.fd = -1;
+	this -> persistent--;
+}
+
+// reads /proc/[pid]/stat into buf, returns length or -1 with errno set,
+// ENOENT or ESRCH when process is gone
+ssize_t common::proc_table::read_stat(pid_t pid, common::proc_table::entry& e) {
+
+	int fd = e.fd;
+
+	if ( fd < 0 ) {
+
+		char path[32];
+		std::snprintf(path, sizeof(path), "%d/stat", (int)pid);
+
+		if (( fd = ::openat(this -> dir_fd, path, O_RDONLY | O_CLOEXEC)) < 0 )
+			return -1;
+
+		if ( this -> persistent < this -> fd_budget ) {
+			e.fd = fd;
+			this -> persistent++;
+		}
+	}
+
+	ssize_t len;
+
+	while (( len = ::pread(fd, this -> buf.data(), this -> buf.size(), 0)) == (ssize_t)this -> buf.size())
+		this -> buf.resize(this -> buf.size() * 2);
+
+	if ( e.fd != fd ) {
+		int err = errno;
+		::close(fd);
+		errno = err;
+	}
+
+	return len;
+}
+
+bool common::proc_table::parse_stat(pid_t pid, size_t len, common::proc_table::entry& e, bool is_new) {
+
+	std::string_view s(this -> buf.data(), len);
+	size_t open = s.find('(');
+	size_t close = s.rfind(')');
+
+	if ( open == std::string_view::npos || close == std::string_view::npos || close < open || close + 4 > len )
+		return false;
+
+	const char* p = s.data() + close + 2;
+	const char* end = s.data() + len;
+	char state = *p++;
+
+	// fields 4 to 24 of proc(5), ppid to rss
+	long long f[25];
+
+	for ( int i = 4; i <= 24; i++ )
+		if ( !next_field(p, end, f[i]))
+			return false;
+
+	uint64_t starttime = f[22];
+	uint64_t ticks = f[14] + f[15];
+	uint64_t delta = 0;
+
+	if ( !is_new && e.starttime == starttime && ticks >= e.ticks )
+		delta = ticks - e.ticks;
+
+	e.starttime = starttime;
+	e.ticks = ticks;
+
+	snapshot& sn = this -> snap;
+	e.row = sn.pid.size();
+	sn.pid.push_back(pid);
+	sn.ppid.push_back(f[4]);
+	sn.state.push_back(state);
+	sn.utime.push_back(f[14]);
+	sn.stime.push_back(f[15]);
+	sn.threads.push_back(f[20]);
+	sn.starttime.push_back(starttime);
+	sn.rss.push_back(f[24] > 0 ? (uint64_t)f[24] * this -> page_size : 0);
+	sn.cpu_delta.push_back(delta);
+	sn.name_offset.push_back(sn.names.size());
+	sn.name_length.push_back(close - open - 1);
+	sn.names.append(s.substr(open + 1, close - open - 1));
+	return true;
+}
+
+void common::proc_table::repeat_previous(pid_t pid, common::proc_table::entry& e) {
+
+	const snapshot& pr = this -> previous;
+	snapshot& sn = this -> snap;
+	size_t i = e.row;
+
+	e.row = sn.pid.size();
+	sn.pid.push_back(pid);
+	sn.ppid.push_back(pr.ppid[i]);
+	sn.state.push_back(pr.state[i]);
+	sn.utime.push_back(pr.utime[i]);
+	sn.stime.push_back(pr.stime[i]);
+	sn.threads.push_back(pr.threads[i]);
+	sn.starttime.push_back(pr.starttime[i]);
+	sn.rss.push_back(pr.rss[i]);
+	sn.cpu_delta.push_back(0);
+	sn.name_offset.push_back(sn.names.size());
+	sn.name_length.push_back(pr.name_length[i]);
+	sn.names.append(pr.name(i));
+}
+
+const common::proc_table::snapshot& common::proc_table::sample() {
+
+	COMMON_TRACE_SCOPE("common::proc_table::sample");
+
+	auto now = std::chrono::steady_clock::now();
+	bool first = this -> generation == 0;
+
+	// rows of previous sample are repeated for processes that cannot be read now
+	std::swap(this -> snap, this -> previous);
+	this -> snap.ticks_per_second = this -> previous.ticks_per_second;
+
+	this -> generation++;
+	this -> snap.clear();
+	this -> snap.reserve(this -> entries.size() + 64);
+	this -> snap.interval = first ? std::chrono::nanoseconds(0) : std::chrono::duration_cast<std::chrono::nanoseconds>(now - this -> previous.time);
+	this -> snap.time = now;
+
+	if ( ::lseek(this -> dir_fd, 0, SEEK_SET) < 0 )
+		throw std::runtime_error(std::string("failed to rewind proc directory: ") + std::strerror(errno));
+
+	long n;
+
+	while (( n = ::syscall(SYS_getdents64, this -> dir_fd, this -> dents.data(), this -> dents.size())) > 0 ) {
+
+		for ( long off = 0; off < n; ) {
+
+			const linux_dirent64* d = reinterpret_cast<const linux_dirent64*>(this -> dents.data() + off);
+			off += d -> d_reclen;
+
+			if ( d -> d_name[0] < '1' || d -> d_name[0] > '9' )
+				continue;
+
+			pid_t pid;
+			const char* name_end = d -> d_name + std::strlen(d -> d_name);
+			auto [ptr, ec] = std::from_chars(d -> d_name, name_end, pid);
+			if ( ec != std::errc() || ptr != name_end )
+				continue;
+
+			auto [it, inserted] = this -> entries.try_emplace(pid);
+			entry& e = it -> second;
+			bool known = !inserted && e.generation == this -> generation - 1;
+			ssize_t len = this -> read_stat(pid, e);
+
+			// kept descriptor may belong to an exited process whose pid was reused
+			if ( len <= 0 && e.fd >= 0 ) {
+				this -> close_entry(e);
+				inserted = true;
+				len = this -> read_stat(pid, e);
+			}
+
+			// out of descriptors or memory, process is still there
+			if ( len < 0 && known && errno != ENOENT && errno != ESRCH ) {
+				this -> repeat_previous(pid, e);
+				e.generation = this -> generation;
+				continue;
+			}
+
+			if ( len <= 0 || !this -> parse_stat(pid, len, e, inserted)) {
+				this -> close_entry(e);
+				this -> entries.erase(it);
+				continue;
+			}
+
+			e.generation = this -> generation;
+		}
+	}
+
+	if ( n < 0 )
+		throw std::runtime_error(std::string("failed to read proc directory: ") + std::strerror(errno));
+
+	for ( auto it = this -> entries.begin(); it != this -> entries.end(); ) {
+
+		if ( it -> second.generation != this -> generation ) {
+			this -> close_entry(it -> second);
+			it = this -> entries.erase(it);
+		} else it++;
+	}
+
+	return this -> snap;
+}
@@ -2,9 +2,19 @@
 #include <limits>
 
 #include "common/scanner.hpp"
+#include "common/alloc_probe.hpp"
+#include "common/trace.hpp"
+#include "common/metrics.hpp"
+
+static common::metrics::counter scan_calls("common_scan_calls_total", "Calls to scan");
+static common::metrics::counter scan_fields("common_scan_fields_total", "Fields parsed by scan");
+static common::metrics::counter scan_failed("common_scan_failed_total", "Calls to scan that stopped at a field that did not parse");
 
 size_t common::scan(const std::string& s, const common::scanner_map& m) {
 
+	COMMON_ALLOC_PROBE();
+	COMMON_TRACE_SCOPE("common::scan");
+
         std::stringstream ss(s + ( std::isspace(s.back()) ? "" : " "));
 	size_t m_len = std::numeric_limits<std::streamsize>::max();
         size_t index = 0;
@@ -45,5 +55,11 @@ size_t common::scan(const std::string& s, const common::scanner_map& m) {
 		else index++;
         }
 
+	scan_calls++;
+	scan_fields += captured;
+
+	if ( failed )
+		scan_failed++;
+
 	return captured;
 }
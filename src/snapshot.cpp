@@ -0,0 +1,83 @@
+#include <string>
+#include <fstream>
+#include <cstdio>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common/snapshot.hpp"
+
+const char* common::snapshot::reader::take(size_t n) {
+
+	if ( n > (size_t)(this -> end - this -> pos))
+		throw std::runtime_error("invalid snapshot, unexpected end of data");
+
+	const char* p = this -> pos;
+	this -> pos += n;
+	return p;
+}
+
+common::snapshot::mapped_file::mapped_file(const std::string& filename) {
+
+	int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+	struct stat st;
+
+	if ( fd == -1 )
+		throw std::runtime_error("fatal error, could not read " + filename);
+
+	if ( ::fstat(fd, &st) == -1 || st.st_size == 0 ) {
+
+		::close(fd);
+		throw std::runtime_error("fatal error, could not read " + filename);
+	}
+
+	this -> length = st.st_size;
+	this -> addr = ::mmap(nullptr, this -> length, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+	::close(fd);
+
+	if ( this -> addr == MAP_FAILED ) {
+
+		this -> addr = nullptr;
+		this -> length = 0;
+		throw std::runtime_error("fatal error, could not map " + filename);
+	}
+}
+
+common::snapshot::mapped_file::~mapped_file() {
+
+	if ( this -> addr != nullptr )
+		::munmap(this -> addr, this -> length);
+}
+
+void common::snapshot::write_file(const std::string& filename, const std::string& payload, uint64_t hash_probe) {
+
+	common::snapshot::header h = {
+		common::snapshot::magic, common::snapshot::version, sizeof(size_t),
+		hash_probe, payload.size()
+	};
+
+	// write to a temporary and rename, so that readers never map a partial snapshot
+	std::string tmpname = filename + ".tmp";
+	std::ofstream fd(tmpname, std::ios::out | std::ios::binary | std::ios::trunc);
+
+	if ( !fd || !fd.good())
+		throw std::runtime_error("fatal error, could not write " + tmpname);
+
+	fd.write(reinterpret_cast<const char*>(&h), sizeof(h));
+	fd.write(payload.data(), payload.size());
+	fd.close();
+
+	if ( fd.fail()) {
+
+		std::remove(tmpname.c_str());
+		throw std::runtime_error("fatal error, could not write " + tmpname);
+	}
+
+	if ( std::rename(tmpname.c_str(), filename.c_str()) != 0 ) {
+
+		std::remove(tmpname.c_str());
+		throw std::runtime_error("fatal error, could not write " + filename);
+	}
+}
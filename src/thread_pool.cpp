@@ -0,0 +1,253 @@
+#include <vector>
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <exception>
+#include <memory_resource>
+
+#include "common/thread_pool.hpp"
+
+namespace {
+
+	const size_t scratch_size = 64 * 1024;
+
+	// keeps its initial block over release(), only growth beyond it is freed
+	struct scratch_arena {
+
+		std::unique_ptr<std::byte[]> buf;
+		std::pmr::monotonic_buffer_resource resource;
+
+		scratch_arena() : buf(new std::byte[scratch_size]), resource(buf.get(), scratch_size) {}
+	};
+}
+
+struct common::thread_pool::job {
+
+	void (*fn)(void*, size_t, size_t);
+	void* body;
+	size_t grain;
+	std::atomic<size_t> remaining; // items not finished or skipped yet
+	std::atomic<bool> failed{false};
+	std::exception_ptr error;
+	std::mutex error_lock;
+};
+
+static thread_local const common::thread_pool* current_pool = nullptr;
+static thread_local size_t current_worker = 0;
+static thread_local scratch_arena* current_scratch = nullptr;
+static thread_local size_t task_depth = 0; // tasks running on this thread, nested ones included
+
+common::thread_pool::thread_pool(size_t threads) {
+
+	if ( threads == 0 ) {
+		unsigned n = std::thread::hardware_concurrency();
+		threads = n > 1 ? n - 1 : 1;
+	}
+
+	for ( size_t i = 0; i <= threads; i++ )
+		this -> queues.push_back(std::make_unique<queue>());
+
+	for ( size_t i = 0; i < threads; i++ )
+		this -> workers.emplace_back(&thread_pool::worker, this, i);
+}
+
+common::thread_pool::~thread_pool() {
+
+	{
+		std::lock_guard<std::mutex> guard(this -> sleep_lock);
+		this -> stop = true;
+	}
+
+	this -> wake.notify_all();
+
+	for ( std::thread& t : this -> workers )
+		t.join();
+}
+
+common::thread_pool& common::thread_pool::shared() {
+
+	static common::thread_pool pool;
+	return pool;
+}
+
+static scratch_arena& thread_scratch() {
+
+	static thread_local scratch_arena arena;
+
+	current_scratch = &arena;
+	return arena;
+}
+
+std::pmr::memory_resource* common::thread_pool::scratch() {
+
+	return &thread_scratch().resource;
+}
+
+void common::thread_pool::release_scratch() {
+
+	thread_scratch().resource.release();
+}
+
+// workers use their own deque, any other thread the shared last one
+size_t common::thread_pool::current_slot() const {
+
+	return current_pool == this ? current_worker : this -> workers.size();
+}
+
+void common::thread_pool::push(size_t slot, const common::thread_pool::task& t) {
+
+	{
+		std::lock_guard<std::mutex> guard(this -> queues[slot] -> lock);
+		this -> queues[slot] -> tasks.push_back(t);
+		this -> queued.fetch_add(1, std::memory_order_release);
+	}
+
+	{
+		// pairs with predicate check of sleepers, no wakeup is lost
+		std::lock_guard<std::mutex> guard(this -> sleep_lock);
+	}
+
+	this -> wake.notify_one();
+}
+
+bool common::thread_pool::pop(size_t slot, common::thread_pool::task& t) {
+
+	std::lock_guard<std::mutex> guard(this -> queues[slot] -> lock);
+
+	if ( this -> queues[slot] -> tasks.empty())
+		return false;
+
+	t = this -> queues[slot] -> tasks.back();
+	this -> queues[slot] -> tasks.pop_back();
+	this -> queued.fetch_sub(1, std::memory_order_relaxed);
+	return true;
+}
+
+// takes oldest, largest, task of another deque
+bool common::thread_pool::steal(size_t slot, common::thread_pool::task& t) {
+
+	size_t n = this -> queues.size();
+
+	for ( size_t i = 1; i < n; i++ ) {
+
+		queue& q = *this -> queues[( slot + i ) % n];
+		std::lock_guard<std::mutex> guard(q.lock);
+
+		if ( q.tasks.empty())
+			continue;
+
+		t = q.tasks.front();
+		q.tasks.pop_front();
+		this -> queued.fetch_sub(1, std::memory_order_relaxed);
+		return true;
+	}
+
+	return false;
+}
+
+void common::thread_pool::execute(size_t slot, common::thread_pool::task t) {
+
+	job& j = *t.owner;
+
+	// leave upper halves for thieves, run the lowest piece here
+	while ( t.end - t.begin > j.grain ) {
+		size_t mid = t.begin + ( t.end - t.begin ) / 2;
+		this -> push(slot, { t.owner, mid, t.end });
+		t.end = mid;
+	}
+
+	task_depth++;
+
+	if ( !j.failed.load(std::memory_order_relaxed)) {
+
+		try {
+			j.fn(j.body, t.begin, t.end);
+		} catch ( ... ) {
+
+			std::lock_guard<std::mutex> guard(j.error_lock);
+
+			if ( !j.error )
+				j.error = std::current_exception();
+
+			j.failed.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	task_depth--;
+
+	// a task run while helping a nested call, or by an outside caller,
+	// returns into code that may still use the arena
+	if ( task_depth == 0 && current_pool != nullptr && current_scratch != nullptr )
+		current_scratch -> resource.release();
+
+	if ( j.remaining.fetch_sub(t.end - t.begin, std::memory_order_acq_rel) == t.end - t.begin ) {
+
+		// owner may be sleeping on the shared condition
+		{
+			std::lock_guard<std::mutex> guard(this -> sleep_lock);
+		}
+
+		this -> wake.notify_all();
+	}
+}
+
+void common::thread_pool::worker(size_t slot) {
+
+	current_pool = this;
+	current_worker = slot;
+
+	task t;
+
+	while ( true ) {
+
+		if ( this -> pop(slot, t) || this -> steal(slot, t)) {
+			this -> execute(slot, t);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(this -> sleep_lock);
+		this -> wake.wait(lock, [this]() { return this -> stop || this -> queued.load(std::memory_order_acquire) > 0; });
+
+		if ( this -> stop )
+			return;
+	}
+}
+
+void common::thread_pool::run(size_t count, size_t grain, void (*fn)(void*, size_t, size_t), void* body) {
+
+	if ( count == 0 )
+		return;
+
+	size_t slot = this -> current_slot();
+
+	if ( grain == 0 )
+		grain = std::max<size_t>(1, count / (( this -> workers.size() + 1 ) * 8 ));
+
+	job j;
+	j.fn = fn;
+	j.body = body;
+	j.grain = grain;
+	j.remaining.store(count, std::memory_order_relaxed);
+
+	this -> push(slot, { &j, 0, count });
+
+	task t;
+
+	// help until all of it is done, possibly running other jobs' tasks
+	while ( j.remaining.load(std::memory_order_acquire) != 0 ) {
+
+		if ( this -> pop(slot, t) || this -> steal(slot, t)) {
+			this -> execute(slot, t);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(this -> sleep_lock);
+		this -> wake.wait(lock, [this, &j]() {
+			return j.remaining.load(std::memory_order_acquire) == 0 || this -> queued.load(std::memory_order_acquire) > 0;
+		});
+	}
+
+	if ( j.error )
+		std::rethrow_exception(j.error);
+}
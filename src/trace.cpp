@@ -0,0 +1,277 @@
+#include <ostream>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "common/trace.hpp"
+
+#ifdef COMMON_TRACE
+
+#include "common/clock.hpp"
+
+namespace {
+
+	// fields are atomics only so that export may run while owner thread
+	// keeps writing; relaxed accesses compile to plain moves
+	struct slot {
+		std::atomic<const char*> name{nullptr};
+		std::atomic<int64_t> ts{0};
+		std::atomic<pid_t> tid{0}; // buffer changes hands when its thread exits
+		std::atomic<char> phase{0};
+	};
+
+	// ring buffer of one thread, written only by that thread
+	struct buffer {
+
+		size_t mask;
+		std::unique_ptr<slot[]> slots;
+		std::atomic<uint64_t> claimed{0}; // bumped before a slot is overwritten
+		std::atomic<uint64_t> written{0}; // bumped after slot is complete
+		std::atomic<uint64_t> cleared{0}; // events below this are ignored
+
+		buffer(size_t capacity) : mask(capacity - 1), slots(new slot[capacity]) {}
+
+		uint64_t first(uint64_t end) const {
+			return std::max(this -> cleared.load(std::memory_order_relaxed), end > this -> mask ? end - this -> mask - 1 : 0);
+		}
+	};
+
+	struct event {
+		const char* name;
+		int64_t ts;
+		pid_t tid;
+		char phase;
+	};
+
+	// owns every buffer, so events outlive threads that recorded them.
+	// Buffer of an exited thread is handed to the next new thread, which
+	// overwrites its events as it records.
+	struct registry {
+
+		std::mutex lock;
+		std::vector<std::unique_ptr<buffer>> buffers;
+		std::vector<buffer*> unused;
+		std::atomic<size_t> capacity{1 << 16};
+		std::atomic<bool> on{true};
+
+		static registry& get() {
+			static registry* r = new registry; // never destroyed, scopes may close during exit
+			return *r;
+		}
+
+		buffer* create() {
+
+			std::lock_guard<std::mutex> guard(this -> lock);
+
+			if ( !this -> unused.empty()) {
+				buffer* b = this -> unused.back();
+				this -> unused.pop_back();
+				return b;
+			}
+
+			this -> buffers.push_back(std::make_unique<buffer>(this -> capacity.load(std::memory_order_relaxed)));
+			return this -> buffers.back().get();
+		}
+	};
+}
+
+static thread_local buffer* local_buffer = nullptr;
+static thread_local pid_t local_tid = 0;
+
+// returns buffer of thread to registry when thread exits
+static thread_local struct buffer_release {
+
+	~buffer_release() {
+
+		if ( local_buffer == nullptr )
+			return;
+
+		registry& r = registry::get();
+		std::lock_guard<std::mutex> guard(r.lock);
+		r.unused.push_back(local_buffer);
+		local_buffer = nullptr;
+	}
+} local_release;
+
+static void record(const char* name, char phase) {
+
+	if ( local_buffer == nullptr ) {
+		local_buffer = registry::get().create();
+		local_tid = (pid_t)::syscall(SYS_gettid);
+		(void)&local_release; // registers release on thread exit
+	}
+
+	buffer* b = local_buffer;
+	uint64_t i = b -> written.load(std::memory_order_relaxed);
+	slot& s = b -> slots[i & b -> mask];
+
+	b -> claimed.store(i + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	s.name.store(name, std::memory_order_relaxed);
+	s.ts.store(common::clock::tsc::now().time_since_epoch().count(), std::memory_order_relaxed);
+	s.tid.store(local_tid, std::memory_order_relaxed);
+	s.phase.store(phase, std::memory_order_relaxed);
+
+	b -> written.store(i + 1, std::memory_order_release);
+}
+
+// copies consistent events of a buffer, events overwritten while copying are dropped
+static std::vector<event> copy_events(const buffer& b) {
+
+	uint64_t end = b.written.load(std::memory_order_acquire);
+	uint64_t begin = b.first(end);
+	std::vector<event> v;
+	v.reserve(end - begin);
+
+	for ( uint64_t i = begin; i < end; i++ ) {
+		const slot& s = b.slots[i & b.mask];
+		v.push_back({ s.name.load(std::memory_order_relaxed), s.ts.load(std::memory_order_relaxed),
+			s.tid.load(std::memory_order_relaxed), s.phase.load(std::memory_order_relaxed) });
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uint64_t claimed = b.claimed.load(std::memory_order_relaxed);
+
+	if ( claimed > b.mask + 1 && claimed - b.mask - 1 > begin )
+		v.erase(v.begin(), v.begin() + std::min((size_t)( claimed - b.mask - 1 - begin ), v.size()));
+
+	return v;
+}
+
+static void write_string(std::ostream& os, const char* s) {
+
+	os << '"';
+
+	for ( ; *s != 0; s++ ) {
+
+		if ( *s == '"' || *s == '\\' )
+			os << '\\' << *s;
+		else if ((unsigned char)*s < 0x20 )
+			os << ' ';
+		else os << *s;
+	}
+
+	os << '"';
+}
+
+void common::trace::begin(const char* name) {
+
+	record(name, 'B');
+}
+
+void common::trace::end(const char* name) {
+
+	record(name, 'E');
+}
+
+void common::trace::set_capacity(size_t events) {
+
+	size_t capacity = 16;
+
+	while ( capacity < events )
+		capacity <<= 1;
+
+	registry::get().capacity.store(capacity, std::memory_order_relaxed);
+}
+
+void common::trace::enable(bool on) {
+
+	registry::get().on.store(on, std::memory_order_relaxed);
+}
+
+bool common::trace::enabled() {
+
+	return registry::get().on.load(std::memory_order_relaxed);
+}
+
+size_t common::trace::size() {
+
+	registry& r = registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+	size_t n = 0;
+
+	for ( const auto& b : r.buffers ) {
+		uint64_t end = b -> written.load(std::memory_order_acquire);
+		n += end - b -> first(end);
+	}
+
+	return n;
+}
+
+void common::trace::write_json(std::ostream& os) {
+
+	registry& r = registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+	pid_t pid = ::getpid();
+	bool first = true;
+
+	os << "{\"traceEvents\":[";
+
+	for ( const auto& b : r.buffers ) {
+
+		size_t depth = 0;
+		pid_t tid = 0;
+
+		for ( const event& e : copy_events(*b)) {
+
+			if ( e.tid != tid ) {
+				tid = e.tid;
+				depth = 0;
+			}
+
+			// begin of this one was overwritten
+			if ( e.phase == 'E' && depth == 0 )
+				continue;
+
+			depth += e.phase == 'B' ? 1 : -1;
+
+			os << ( first ? "\n" : ",\n" ) << "{\"name\":";
+			write_string(os, e.name);
+			os << ",\"ph\":\"" << e.phase << "\",\"ts\":" << e.ts / 1000 << '.' <<
+				(char)( '0' + e.ts / 100 % 10 ) << (char)( '0' + e.ts / 10 % 10 ) << (char)( '0' + e.ts % 10 ) <<
+				",\"pid\":" << pid << ",\"tid\":" << e.tid << "}";
+
+			first = false;
+		}
+	}
+
+	os << "\n],\"displayTimeUnit\":\"ns\"}" << std::endl;
+}
+
+void common::trace::clear() {
+
+	registry& r = registry::get();
+	std::lock_guard<std::mutex> guard(r.lock);
+
+	for ( auto& b : r.buffers )
+		b -> cleared.store(b -> written.load(std::memory_order_acquire), std::memory_order_relaxed);
+}
+
+#else
+
+void common::trace::set_capacity(size_t) {}
+void common::trace::enable(bool) {}
+
+bool common::trace::enabled() {
+
+	return false;
+}
+
+size_t common::trace::size() {
+
+	return 0;
+}
+
+void common::trace::write_json(std::ostream& os) {
+
+	os << "{\"traceEvents\":[],\"displayTimeUnit\":\"ns\"}" << std::endl;
+}
+
+void common::trace::clear() {}
+
+#endif